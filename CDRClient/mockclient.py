@@ -1,9 +1,22 @@
-from fastapi import FastAPI, Request
+from fastapi import FastAPI, HTTPException, Request
 from typing import List, Optional
-from pydantic import BaseModel
+from pydantic import BaseModel, ValidationError, parse_obj_as
+import asyncio
+import os
+import random
+import sys
+
+# The binary batch codec lives next to the DataSources mock.
+sys.path.append(os.path.join(os.path.dirname(__file__), '..', 'DataSources'))
+import binary_batch  # noqa: E402
 
 app = FastAPI()
 
+# Fault injection for delivery testing: CDR_FAIL_RATE of the requests are
+# answered 503, every request is delayed by CDR_DELAY_MS.
+FAIL_RATE = float(os.environ.get("CDR_FAIL_RATE", "0"))
+DELAY_MS = int(os.environ.get("CDR_DELAY_MS", "0"))
+
 class CDR(BaseModel):
     call_id: int
     initiator_phone: str
@@ -19,9 +32,28 @@ class CDR(BaseModel):
     number_of_events: int
 
 @app.post("/records")
-async def receive_cdr_batch(cdrs: List[CDR]):
+async def receive_cdr_batch(request: Request):
+    if DELAY_MS:
+        await asyncio.sleep(DELAY_MS / 1000)
+    if random.random() < FAIL_RATE:
+        raise HTTPException(status_code=503, detail="Injected failure")
+
+    content_type = request.headers.get("content-type")
+    if binary_batch.is_binary(content_type):
+        try:
+            records, _ = binary_batch.decode("external_cdr", await request.body())
+        except ValueError as e:
+            raise HTTPException(status_code=400, detail=str(e))
+    elif (content_type or "application/json").split(";")[0].strip() == "application/json":
+        try:
+            records = [cdr.dict() for cdr in parse_obj_as(List[CDR], await request.json())]
+        except ValidationError as e:
+            raise HTTPException(status_code=422, detail=e.errors())
+    else:
+        raise HTTPException(status_code=415, detail="Unsupported content type")
+
     print("\n--- Received CDR batch ---")
-    for record in cdrs:
-        print(record.json())
+    for record in records:
+        print(record)
     print("--- End of batch ---\n")
-    return {"status": "OK", "received": len(cdrs)}
+    return {"status": "OK", "received": len(records)}
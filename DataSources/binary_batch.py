@@ -0,0 +1,179 @@
+"""Binary batch format shared with the service (Service/src/parsers/binary_batch.hpp).
+
+    batch := "CFB" version:u8 schema:u8 flags:u8 row_count:varint row*
+    row   := length:varint field*
+
+Integers are zigzag varints, strings are varint length + UTF-8 bytes,
+timestamps are microseconds since the epoch, optionals are a 0/1 presence
+byte followed by the value. Flag bit 0 marks a page with more rows after it.
+"""
+
+import datetime
+import json
+
+CONTENT_TYPE = 'application/x-cfp-batch'
+
+MAGIC = b'CFB'
+VERSION = 2
+FLAG_HAS_MORE = 1
+
+INT, STRING, TIME, OPT_TIME, OPT_STRING, JSON_TEXT = range(6)
+
+# Field order is the wire order and must match Fields() in binary_batch.cpp.
+SCHEMAS = {
+    'call': (1, [('id', INT), ('status', STRING), ('started_at', TIME),
+                 ('user_id', INT), ('finished_at', OPT_TIME),
+                 ('caller_number', STRING), ('callee_number', STRING)]),
+    'connection': (2, [('connection_id', INT), ('call_id', INT),
+                       ('phone', STRING), ('initiated_at', TIME),
+                       ('answered_at', OPT_TIME), ('finished_at', OPT_TIME)]),
+    'call_event': (3, [('event_id', INT), ('call_id', INT),
+                       ('event_type', STRING), ('payload', JSON_TEXT)]),
+    'operator': (4, [('operator_id', INT), ('name', STRING),
+                     ('extension', STRING), ('email', STRING)]),
+    'external_cdr': (5, [('call_id', STRING), ('call_start', TIME),
+                         ('call_end', TIME), ('caller_number', STRING),
+                         ('operator_id', OPT_STRING),
+                         ('operator_name', OPT_STRING),
+                         ('agent_status', STRING), ('wait_sec', INT),
+                         ('talk_sec', INT), ('end_reason', STRING)]),
+}
+
+EPOCH = datetime.datetime(1970, 1, 1, tzinfo=datetime.timezone.utc)
+
+
+def is_binary(content_type):
+    return (content_type or '').split(';')[0].strip() == CONTENT_TYPE
+
+
+def accepts_binary(accept):
+    return any(part.split(';')[0].strip() == CONTENT_TYPE
+               for part in (accept or '').split(','))
+
+
+def _varint(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+def _int(out, value):
+    _varint(out, ((value << 1) ^ (value >> 63)) & 0xFFFFFFFFFFFFFFFF)
+
+
+def _string(out, value):
+    data = value.encode()
+    _varint(out, len(data))
+    out += data
+
+
+def _micros(value):
+    if isinstance(value, str):
+        value = datetime.datetime.fromisoformat(value.replace('Z', '+00:00'))
+    if isinstance(value, datetime.datetime):
+        return (value - EPOCH) // datetime.timedelta(microseconds=1)
+    return int(value)
+
+
+def _field(out, kind, value):
+    if kind in (OPT_TIME, OPT_STRING):
+        out.append(0 if value is None else 1)
+        if value is None:
+            return
+        kind = TIME if kind == OPT_TIME else STRING
+    if kind == INT:
+        _int(out, value)
+    elif kind == STRING:
+        _string(out, value)
+    elif kind == JSON_TEXT:
+        _string(out, value if isinstance(value, str) else json.dumps(value))
+    else:
+        _int(out, _micros(value))
+
+
+def encode(schema, rows, has_more=False):
+    """Encodes dict rows. Rows lacking a required field are left out, as
+    the service would reject them anyway."""
+    schema_id, fields = SCHEMAS[schema]
+    encoded = []
+    for row in rows:
+        body = bytearray()
+        try:
+            for name, kind in fields:
+                value = row.get(name)
+                if value is None and kind not in (OPT_TIME, OPT_STRING):
+                    raise KeyError(name)
+                _field(body, kind, value)
+        except KeyError:
+            continue
+        encoded.append(body)
+
+    out = bytearray(MAGIC)
+    out += bytes([VERSION, schema_id, FLAG_HAS_MORE if has_more else 0])
+    _varint(out, len(encoded))
+    for body in encoded:
+        _varint(out, len(body))
+        out += body
+    return bytes(out)
+
+
+class _Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError('unexpected end of batch')
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def bytes(self, size):
+        if size > len(self.data) - self.pos:
+            raise ValueError('unexpected end of batch')
+        self.pos += size
+        return self.data[self.pos - size:self.pos]
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            byte = self.byte()
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+
+    def int(self):
+        raw = self.varint()
+        return (raw >> 1) ^ -(raw & 1)
+
+    def field(self, kind):
+        if kind in (OPT_TIME, OPT_STRING):
+            if not self.byte():
+                return None
+            kind = TIME if kind == OPT_TIME else STRING
+        if kind == INT:
+            return self.int()
+        if kind in (STRING, JSON_TEXT):
+            return self.bytes(self.varint()).decode()
+        return (EPOCH + datetime.timedelta(microseconds=self.int())).isoformat()
+
+
+def decode(schema, data):
+    """Returns (rows, has_more). Bytes after the known fields of a row are
+    ignored."""
+    schema_id, fields = SCHEMAS[schema]
+    reader = _Reader(data)
+    if reader.bytes(3) != MAGIC or reader.byte() != VERSION:
+        raise ValueError('not a binary batch')
+    if reader.byte() != schema_id:
+        raise ValueError('batch schema does not match ' + schema)
+    has_more = bool(reader.byte() & FLAG_HAS_MORE)
+    rows = []
+    for _ in range(reader.varint()):
+        row_reader = _Reader(reader.bytes(reader.varint()))
+        rows.append({name: row_reader.field(kind) for name, kind in fields})
+    if reader.pos != len(data):
+        raise ValueError('trailing data after the last row')
+    return rows, has_more
@@ -1,8 +1,11 @@
-from fastapi import FastAPI, Query
+from fastapi import FastAPI, Header, Query, Response
 from typing import Optional
 from pydantic import BaseModel
 import json
 import os
+import zlib
+
+import binary_batch
 
 app = FastAPI()
 
@@ -50,7 +53,13 @@ CONNECTIONS = [Connection(**o) for o in load_mock_data("connections.json", "conn
 CALL_EVENTS = [CallEvent(**o) for o in load_mock_data("call_events.json", "call_events")]
 OPERATORS = [Operator(**o) for o in load_mock_data("operators.json", "operators")]
 
-def paginate(data, cursor: Optional[int], limit: int, id_key: str):
+def in_partition(key: int, partition: int, partitions: int) -> bool:
+    return zlib.crc32(str(key).encode()) % partitions == partition
+
+def paginate(data, cursor: Optional[int], limit: int, id_key: str,
+             partition: int = 0, partitions: int = 1):
+    if partitions > 1:
+        data = [x for x in data if in_partition(getattr(x, id_key), partition, partitions)]
     data = sorted(data, key=lambda x: getattr(x, id_key))
     idx = 0
     if cursor is not None:
@@ -64,19 +73,33 @@ def paginate(data, cursor: Optional[int], limit: int, id_key: str):
     next_cursor = getattr(results[-1], id_key) if len(results) == limit else None
     return {"results": [r.dict() for r in results], "next_cursor": next_cursor}
 
+def respond(page, schema: str, accept: Optional[str]):
+    if not binary_batch.accepts_binary(accept):
+        return page
+    body = binary_batch.encode(schema, page["results"], page["next_cursor"] is not None)
+    return Response(content=body, media_type=binary_batch.CONTENT_TYPE)
+
 @app.get("/calls")
-def list_calls(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0)):
-    return paginate(CALLS, cursor, limit, "call_id")
+def list_calls(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0),
+               partition: int = Query(0, ge=0), partitions: int = Query(1, gt=0),
+               accept: Optional[str] = Header(None)):
+    return respond(paginate(CALLS, cursor, limit, "call_id", partition, partitions), "call", accept)
 
 @app.get("/connections")
-def list_connections(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0)):
-    return paginate(CONNECTIONS, cursor, limit, "connection_id")
+def list_connections(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0),
+                     partition: int = Query(0, ge=0), partitions: int = Query(1, gt=0),
+                     accept: Optional[str] = Header(None)):
+    return respond(paginate(CONNECTIONS, cursor, limit, "connection_id", partition, partitions), "connection", accept)
 
 @app.get("/call_events")
-def list_call_events(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0)):
-    return paginate(CALL_EVENTS, cursor, limit, "event_id")
+def list_call_events(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0),
+                     partition: int = Query(0, ge=0), partitions: int = Query(1, gt=0),
+                     accept: Optional[str] = Header(None)):
+    return respond(paginate(CALL_EVENTS, cursor, limit, "event_id", partition, partitions), "call_event", accept)
 
 @app.get("/operators")
-def list_operators(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0)):
-    return paginate(OPERATORS, cursor, limit, "operator_id")
+def list_operators(cursor: Optional[int] = Query(None), limit: int = Query(10, gt=0),
+                   partition: int = Query(0, ge=0), partitions: int = Query(1, gt=0),
+                   accept: Optional[str] = Header(None)):
+    return respond(paginate(OPERATORS, cursor, limit, "operator_id", partition, partitions), "operator", accept)
 
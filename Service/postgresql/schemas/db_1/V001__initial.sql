@@ -0,0 +1,119 @@
+DROP SCHEMA IF EXISTS call_flow_processor CASCADE;
+
+CREATE SCHEMA IF NOT EXISTS call_flow_processor;
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.calls (
+    call_id         BIGINT PRIMARY KEY,
+    call_type       VARCHAR,
+    scenario_id     VARCHAR,
+    initiator_phone VARCHAR,
+    media_record_id VARCHAR,
+    initiated_at    TIMESTAMP,
+    finished_at     TIMESTAMP,
+    context         JSON
+);
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.connections (
+    connection_id   BIGINT PRIMARY KEY,
+    call_id         BIGINT,
+    phone           VARCHAR,
+    initiated_at    TIMESTAMP,
+    answered_at     TIMESTAMP,
+    finished_at     TIMESTAMP,
+    FOREIGN KEY (call_id) REFERENCES call_flow_processor.calls(call_id)
+);
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.call_events (
+    event_id    BIGINT PRIMARY KEY,
+    call_id     BIGINT,
+    event_type  VARCHAR,
+    payload     JSON,
+    FOREIGN KEY (call_id) REFERENCES call_flow_processor.calls(call_id)
+);
+
+-- finished_txid is the id of the transaction that recorded the call. CDR
+-- uploaders discover new rows by it, see cdr_uploader_watermarks.
+CREATE TABLE IF NOT EXISTS call_flow_processor.finished_calls (
+    call_id         BIGINT PRIMARY KEY,
+    call_type       VARCHAR,
+    scenario_id     VARCHAR,
+    finished_txid   BIGINT NOT NULL DEFAULT txid_current()
+);
+
+CREATE INDEX IF NOT EXISTS finished_calls_finished_txid_idx
+    ON call_flow_processor.finished_calls (finished_txid);
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.cdr_upload_info (
+    call_id             BIGINT,
+    cdr_uploader_id     VARCHAR,
+    upload_status       VARCHAR,
+    created_at          TIMESTAMP,
+    uploaded_at         TIMESTAMP,
+    -- Work queue lease: the worker holding a pending row and until when.
+    -- After a failed upload lease_until is the time of the next attempt
+    -- and attempts the number of failed uploads.
+    lease_owner         VARCHAR,
+    lease_until         TIMESTAMPTZ,
+    attempts            INTEGER NOT NULL DEFAULT 0,
+    PRIMARY KEY (call_id, cdr_uploader_id),
+    FOREIGN KEY (call_id) REFERENCES call_flow_processor.calls(call_id)
+);
+
+-- Per uploader: every finished_calls row with finished_txid below
+-- finished_txid has already been enqueued into cdr_upload_info.
+CREATE TABLE IF NOT EXISTS call_flow_processor.cdr_uploader_watermarks (
+    cdr_uploader_id VARCHAR PRIMARY KEY,
+    finished_txid   BIGINT NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.distlocks (
+    key             VARCHAR PRIMARY KEY,
+    owner           TEXT,
+    expiration_time TIMESTAMP
+);
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.data_fetchers (
+    fetcher_id  VARCHAR PRIMARY KEY,
+    cursor      BIGINT
+);
+
+CREATE TABLE IF NOT EXISTS call_flow_processor.operators (
+    operator_id BIGINT PRIMARY KEY,
+    name        VARCHAR NOT NULL,
+    extension   VARCHAR NOT NULL,
+    email       VARCHAR NOT NULL
+);
+
+-- Staging tables for the `write-mode: staging` bulk-load path of the data
+-- fetchers. Rows are appended without conflict checks and merged into the
+-- main tables with one set-based upsert, newest staged_seq winning.
+CREATE UNLOGGED TABLE IF NOT EXISTS call_flow_processor.calls_staging (
+    LIKE call_flow_processor.calls,
+    staged_seq  BIGSERIAL
+);
+
+CREATE UNLOGGED TABLE IF NOT EXISTS call_flow_processor.connections_staging (
+    LIKE call_flow_processor.connections,
+    staged_seq  BIGSERIAL
+);
+
+CREATE UNLOGGED TABLE IF NOT EXISTS call_flow_processor.call_events_staging (
+    LIKE call_flow_processor.call_events,
+    staged_seq  BIGSERIAL
+);
+
+CREATE UNLOGGED TABLE IF NOT EXISTS call_flow_processor.operators_staging (
+    LIKE call_flow_processor.operators,
+    staged_seq  BIGSERIAL
+);
+
+-- Every file of this directory is a migration applied in file name order;
+-- each records its version here.
+CREATE TABLE IF NOT EXISTS call_flow_processor.schema_migrations (
+    version     INTEGER PRIMARY KEY,
+    name        VARCHAR NOT NULL,
+    applied_at  TIMESTAMPTZ NOT NULL DEFAULT now()
+);
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (1, 'initial') ON CONFLICT DO NOTHING;
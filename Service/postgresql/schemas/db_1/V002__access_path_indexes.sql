@@ -0,0 +1,21 @@
+-- Indexes for the lookups the service runs on every CDR batch.
+
+-- The code has always called the uploader column cdr_type.
+ALTER TABLE call_flow_processor.cdr_upload_info RENAME COLUMN cdr_uploader_id TO cdr_type;
+
+-- CallEventController::GetEvents and ConnectionController::GetConnections
+-- look rows up by call_id = ANY($1).
+CREATE INDEX IF NOT EXISTS call_events_call_id_idx
+    ON call_flow_processor.call_events (call_id);
+
+CREATE INDEX IF NOT EXISTS connections_call_id_idx
+    ON call_flow_processor.connections (call_id);
+
+-- CDRUploadInfo::ClaimPending: pending rows of one uploader in call_id
+-- order. Uploaded rows are the vast majority and are left out.
+CREATE INDEX IF NOT EXISTS cdr_upload_info_pending_idx
+    ON call_flow_processor.cdr_upload_info (cdr_type, call_id)
+    WHERE upload_status = 'pending';
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (2, 'access_path_indexes') ON CONFLICT DO NOTHING;
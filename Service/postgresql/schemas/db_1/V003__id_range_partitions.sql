@@ -0,0 +1,119 @@
+-- calls, connections and call_events are range-partitioned by their ids.
+-- The sources hand ids out in increasing order, so a range of ids is a
+-- range of time and old data goes away by detaching whole partitions.
+-- A timestamp partition key would have to be part of every primary key,
+-- which the id upserts (ON CONFLICT on the id) and the foreign keys to
+-- calls can't express.
+
+-- Partition width per table; ranges are [n * width, (n + 1) * width).
+CREATE TABLE IF NOT EXISTS call_flow_processor.id_partitioning (
+    parent      VARCHAR PRIMARY KEY,
+    key_column  VARCHAR NOT NULL,
+    width       BIGINT NOT NULL
+);
+
+INSERT INTO call_flow_processor.id_partitioning (parent, key_column, width) VALUES
+    ('calls', 'call_id', 1000000),
+    ('connections', 'connection_id', 1000000),
+    ('call_events', 'event_id', 1000000)
+ON CONFLICT DO NOTHING;
+
+-- Creates partition <parent>_p<range_index> unless it exists. Returns false
+-- when rows of the range already landed in the default partition; they
+-- stay there.
+CREATE OR REPLACE FUNCTION call_flow_processor.create_id_partition(parent_name TEXT, range_index BIGINT)
+RETURNS BOOLEAN
+LANGUAGE plpgsql AS $$
+DECLARE
+    partition_width BIGINT;
+    partition_name TEXT := format('%s_p%s', parent_name, range_index);
+BEGIN
+    IF to_regclass(format('call_flow_processor.%I', partition_name)) IS NOT NULL THEN
+        RETURN FALSE;
+    END IF;
+    SELECT width INTO STRICT partition_width FROM call_flow_processor.id_partitioning WHERE parent = parent_name;
+    EXECUTE format(
+        'CREATE TABLE call_flow_processor.%I PARTITION OF call_flow_processor.%I FOR VALUES FROM (%s) TO (%s)',
+        partition_name, parent_name, range_index * partition_width, (range_index + 1) * partition_width);
+    RETURN TRUE;
+EXCEPTION WHEN check_violation THEN
+    RETURN FALSE;
+END;
+$$;
+
+-- Keeps `ahead` empty partitions above the highest id of the table, so new
+-- rows never fall into the default partition. Returns the number created.
+CREATE OR REPLACE FUNCTION call_flow_processor.ensure_id_partitions(parent_name TEXT, ahead INTEGER DEFAULT 4)
+RETURNS INTEGER
+LANGUAGE plpgsql AS $$
+DECLARE
+    spec call_flow_processor.id_partitioning%ROWTYPE;
+    max_range BIGINT;
+    created INTEGER := 0;
+BEGIN
+    SELECT * INTO STRICT spec FROM call_flow_processor.id_partitioning WHERE parent = parent_name;
+    EXECUTE format('SELECT COALESCE(max(%I), 0) / $1 FROM call_flow_processor.%I', spec.key_column, spec.parent)
+        INTO max_range USING spec.width;
+    FOR range_index IN max_range .. max_range + ahead LOOP
+        IF call_flow_processor.create_id_partition(spec.parent, range_index) THEN
+            created := created + 1;
+        END IF;
+    END LOOP;
+    RETURN created;
+END;
+$$;
+
+ALTER TABLE call_flow_processor.connections DROP CONSTRAINT IF EXISTS connections_call_id_fkey;
+ALTER TABLE call_flow_processor.call_events DROP CONSTRAINT IF EXISTS call_events_call_id_fkey;
+ALTER TABLE call_flow_processor.cdr_upload_info DROP CONSTRAINT IF EXISTS cdr_upload_info_call_id_fkey;
+
+DO $$
+DECLARE
+    spec call_flow_processor.id_partitioning%ROWTYPE;
+    old_name TEXT;
+    min_range BIGINT;
+    max_range BIGINT;
+BEGIN
+    FOR spec IN SELECT * FROM call_flow_processor.id_partitioning LOOP
+        old_name := spec.parent || '_unpartitioned';
+        EXECUTE format('ALTER TABLE call_flow_processor.%I RENAME TO %I', spec.parent, old_name);
+        EXECUTE format(
+            'CREATE TABLE call_flow_processor.%I (LIKE call_flow_processor.%I INCLUDING DEFAULTS) '
+            'PARTITION BY RANGE (%I)',
+            spec.parent, old_name, spec.key_column);
+        EXECUTE format(
+            'CREATE TABLE call_flow_processor.%I PARTITION OF call_flow_processor.%I DEFAULT',
+            spec.parent || '_default', spec.parent);
+
+        EXECUTE format(
+            'SELECT COALESCE(min(%1$I), 0) / $1, COALESCE(max(%1$I), 0) / $1 FROM call_flow_processor.%2$I',
+            spec.key_column, old_name)
+            INTO min_range, max_range USING spec.width;
+        FOR range_index IN min_range .. max_range LOOP
+            PERFORM call_flow_processor.create_id_partition(spec.parent, range_index);
+        END LOOP;
+
+        EXECUTE format(
+            'INSERT INTO call_flow_processor.%I SELECT * FROM call_flow_processor.%I', spec.parent, old_name);
+        EXECUTE format('DROP TABLE call_flow_processor.%I', old_name);
+        EXECUTE format('ALTER TABLE call_flow_processor.%I ADD PRIMARY KEY (%I)', spec.parent, spec.key_column);
+        PERFORM call_flow_processor.ensure_id_partitions(spec.parent);
+    END LOOP;
+END;
+$$;
+
+CREATE INDEX IF NOT EXISTS call_events_call_id_idx
+    ON call_flow_processor.call_events (call_id);
+
+CREATE INDEX IF NOT EXISTS connections_call_id_idx
+    ON call_flow_processor.connections (call_id);
+
+ALTER TABLE call_flow_processor.connections
+    ADD FOREIGN KEY (call_id) REFERENCES call_flow_processor.calls(call_id);
+ALTER TABLE call_flow_processor.call_events
+    ADD FOREIGN KEY (call_id) REFERENCES call_flow_processor.calls(call_id);
+ALTER TABLE call_flow_processor.cdr_upload_info
+    ADD FOREIGN KEY (call_id) REFERENCES call_flow_processor.calls(call_id);
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (3, 'id_range_partitions') ON CONFLICT DO NOTHING;
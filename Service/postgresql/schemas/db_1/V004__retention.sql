@@ -0,0 +1,54 @@
+-- Retention: CallRetention archives old uploaded calls into gzip files and
+-- deletes them; archived_calls tells where each one went.
+
+CREATE INDEX IF NOT EXISTS calls_finished_at_idx
+    ON call_flow_processor.calls (finished_at);
+
+-- One gzip member per archived chunk: archive_offset and archive_length
+-- locate the member holding the call inside archive_file.
+CREATE TABLE IF NOT EXISTS call_flow_processor.archived_calls (
+    call_id         BIGINT PRIMARY KEY,
+    archive_file    VARCHAR NOT NULL,
+    archive_offset  BIGINT NOT NULL,
+    archive_length  BIGINT NOT NULL,
+    archived_at     TIMESTAMPTZ NOT NULL DEFAULT now()
+);
+
+-- Drops the partitions of parent_name that are empty and lie below the one
+-- holding the highest id, so the ranges still being written are kept.
+-- Returns the number dropped.
+CREATE OR REPLACE FUNCTION call_flow_processor.drop_empty_id_partitions(parent_name TEXT)
+RETURNS INTEGER
+LANGUAGE plpgsql AS $$
+DECLARE
+    spec call_flow_processor.id_partitioning%ROWTYPE;
+    max_range BIGINT;
+    partition_name TEXT;
+    is_empty BOOLEAN;
+    dropped INTEGER := 0;
+BEGIN
+    SELECT * INTO STRICT spec FROM call_flow_processor.id_partitioning WHERE parent = parent_name;
+    EXECUTE format('SELECT COALESCE(max(%I), 0) / $1 FROM call_flow_processor.%I', spec.key_column, spec.parent)
+        INTO max_range USING spec.width;
+
+    FOR partition_name IN
+        SELECT child.relname
+        FROM pg_inherits
+        JOIN pg_class child ON child.oid = pg_inherits.inhrelid
+        WHERE pg_inherits.inhparent = format('call_flow_processor.%I', spec.parent)::regclass
+          AND child.relname ~ ('^' || spec.parent || '_p[0-9]+$')
+          AND substring(child.relname FROM '[0-9]+$')::BIGINT < max_range
+    LOOP
+        EXECUTE format('SELECT NOT EXISTS (SELECT 1 FROM call_flow_processor.%I)', partition_name) INTO is_empty;
+        CONTINUE WHEN NOT is_empty;
+        EXECUTE format('ALTER TABLE call_flow_processor.%I DETACH PARTITION call_flow_processor.%I',
+                       spec.parent, partition_name);
+        EXECUTE format('DROP TABLE call_flow_processor.%I', partition_name);
+        dropped := dropped + 1;
+    END LOOP;
+    RETURN dropped;
+END;
+$$;
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (4, 'retention') ON CONFLICT DO NOTHING;
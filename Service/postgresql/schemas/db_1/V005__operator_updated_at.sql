@@ -0,0 +1,11 @@
+-- operator-cache reads operators incrementally: every update reads the rows
+-- changed since the previous one by updated_at.
+
+ALTER TABLE call_flow_processor.operators
+    ADD COLUMN IF NOT EXISTS updated_at TIMESTAMPTZ NOT NULL DEFAULT now();
+
+CREATE INDEX IF NOT EXISTS operators_updated_at_idx
+    ON call_flow_processor.operators (updated_at);
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (5, 'operator_updated_at') ON CONFLICT DO NOTHING;
@@ -0,0 +1,12 @@
+-- Payloads are stored as JSONB: PostgreSQL parses them once on insert
+-- instead of on every read that looks inside them, and the raw text the
+-- service sends is validated on the way in.
+
+ALTER TABLE call_flow_processor.call_events
+    ALTER COLUMN payload TYPE JSONB USING payload::jsonb;
+
+ALTER TABLE call_flow_processor.call_events_staging
+    ALTER COLUMN payload TYPE JSONB USING payload::jsonb;
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (6, 'call_event_payload_jsonb') ON CONFLICT DO NOTHING;
@@ -0,0 +1,19 @@
+-- The call columns CallController writes. The key keeps its name call_id,
+-- which the partitioning, the foreign keys and retention rely on; the
+-- controllers and the CDR assembly statements use it too.
+ALTER TABLE call_flow_processor.calls
+    ADD COLUMN IF NOT EXISTS status         VARCHAR,
+    ADD COLUMN IF NOT EXISTS started_at     TIMESTAMP,
+    ADD COLUMN IF NOT EXISTS caller_number  VARCHAR,
+    ADD COLUMN IF NOT EXISTS callee_number  VARCHAR,
+    ADD COLUMN IF NOT EXISTS user_id        BIGINT;
+
+ALTER TABLE call_flow_processor.calls_staging
+    ADD COLUMN IF NOT EXISTS status         VARCHAR,
+    ADD COLUMN IF NOT EXISTS started_at     TIMESTAMP,
+    ADD COLUMN IF NOT EXISTS caller_number  VARCHAR,
+    ADD COLUMN IF NOT EXISTS callee_number  VARCHAR,
+    ADD COLUMN IF NOT EXISTS user_id        BIGINT;
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (7, 'call_columns') ON CONFLICT DO NOTHING;
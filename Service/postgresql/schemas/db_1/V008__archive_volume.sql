@@ -0,0 +1,12 @@
+-- The volume CallRetention archives to, see CallArchive::VolumeId(). Every
+-- instance checks its archive-dir against it, so one with a local directory
+-- instead of the shared volume is detected rather than serving 404s or
+-- splitting the archive.
+CREATE TABLE IF NOT EXISTS call_flow_processor.archive_volume (
+    single         BOOLEAN PRIMARY KEY DEFAULT TRUE CHECK (single),
+    volume_id      VARCHAR NOT NULL,
+    registered_at  TIMESTAMPTZ NOT NULL DEFAULT now()
+);
+
+INSERT INTO call_flow_processor.schema_migrations (version, name)
+VALUES (8, 'archive_volume') ON CONFLICT DO NOTHING;
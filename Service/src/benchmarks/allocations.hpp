@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+namespace call_flow_processor::benchmarks {
+
+// Number of heap allocations the process has made so far. The benchmark
+// executable replaces the global operator new to count them, so the
+// difference around a piece of code is the allocations it made.
+std::size_t AllocationCount();
+
+}  // namespace call_flow_processor::benchmarks
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <userver/cache/base_postgres_cache.hpp>
+#include <userver/dump/aggregates.hpp>
+#include <userver/storages/postgres/io/chrono.hpp>
+#include <string_view>
+#include "models/operator.hpp"
+
+namespace userver::dump {
+
+template <>
+inline constexpr bool kIsDumpedAggregate<call_flow_processor::models::Operator> = true;
+
+}  // namespace userver::dump
+
+namespace call_flow_processor::components::caches {
+
+// Operators by operator_id. Incremental updates read the rows whose
+// updated_at moved since the previous update; writers of operators call
+// InvalidateAsync(kIncremental) after their commit so new operators show up
+// without waiting for update-interval. The cache is dumped to disk and
+// restored from the dump on restart.
+struct OperatorCachePolicy {
+    static constexpr std::string_view kName = "operator-cache";
+
+    using ValueType = models::Operator;
+    static constexpr auto kKeyMember = &models::Operator::operator_id;
+    static constexpr const char* kQuery =
+        "SELECT operator_id, name, extension, email FROM operators";
+    static constexpr const char* kUpdatedField = "updated_at";
+    using UpdatedFieldType = userver::storages::postgres::TimePointTz;
+};
+
+using OperatorCache = userver::components::PgCache<OperatorCachePolicy>;
+
+}  // namespace call_flow_processor::components::caches
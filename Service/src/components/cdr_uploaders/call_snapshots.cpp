@@ -0,0 +1,160 @@
+#include "call_snapshots.hpp"
+#include "snapshot_assembly.hpp"
+#include <userver/components/statistics_storage.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <algorithm>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+
+namespace call_flow_processor::components {
+
+namespace {
+
+// Consumers are tracked as bits of Entry::taken.
+constexpr std::size_t kMaxConsumers = 64;
+
+std::uint64_t AllConsumers(std::size_t count) {
+    return count == kMaxConsumers ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+}
+
+// Batch arenas start with room for a FlatIdMap of the batch's calls at its
+// highest load, so a batch takes a single block from the heap.
+std::size_t ArenaSize(std::size_t calls) {
+    constexpr std::size_t kBytesPerCall = 256;
+    return std::max<std::size_t>(calls, 1) * kBytesPerCall;
+}
+
+}  // namespace
+
+void StageTimings::Write(userver::utils::statistics::Writer& writer) const {
+    for (std::size_t index = 0; index < kCollectStageNames.size(); ++index) {
+        const auto& timing = timings_[index];
+        const auto count = timing.count.load();
+        if (count == 0) continue;
+        const auto* stage = kCollectStageNames[index];
+        writer["count"].ValueWithLabels(count, {"stage", stage});
+        writer["total-us"].ValueWithLabels(timing.total_us.load(), {"stage", stage});
+        writer["last-us"].ValueWithLabels(timing.last_us.load(), {"stage", stage});
+    }
+}
+
+const char* CallSnapshots::kName = "call-snapshots";
+
+CallSnapshots::CallSnapshots(const userver::components::ComponentConfig& config,
+                             const userver::components::ComponentContext& context)
+    : userver::components::LoggableComponentBase(config, context),
+      call_controller_(context.FindComponent<controllers::CallController>("call-controller")),
+      call_event_controller_(context.FindComponent<controllers::CallEventController>("call-event-controller")),
+      connection_controller_(context.FindComponent<controllers::ConnectionController>("connection-controller")),
+      operator_cache_(context.FindComponent<caches::OperatorCache>()),
+      state_(config["capacity"].As<std::size_t>(10000)) {
+    statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>()
+        .GetStorage()
+        .RegisterWriter(
+            "call-snapshots",
+            [this](userver::utils::statistics::Writer& writer) {
+                timings_.Write(writer);
+                writer["hits"] = hits_.load();
+                writer["misses"] = misses_.load();
+                writer["cached"] = state_.Lock()->cache.GetSize();
+            });
+}
+
+CallSnapshots::~CallSnapshots() { statistics_holder_.Unregister(); }
+
+std::size_t CallSnapshots::Register(const std::string& uploader) {
+    auto state = state_.Lock();
+    if (state->consumers.size() == kMaxConsumers) {
+        throw std::runtime_error("CallSnapshots: too many uploaders, cannot register " + uploader);
+    }
+    state->consumers.push_back(uploader);
+    return state->consumers.size() - 1;
+}
+
+std::vector<CallSnapshots::SnapshotPtr> CallSnapshots::Get(
+    std::size_t consumer, const std::vector<std::int64_t>& call_ids) {
+    const std::uint64_t bit = std::uint64_t{1} << consumer;
+    std::pmr::monotonic_buffer_resource arena{ArenaSize(call_ids.size())};
+    FlatIdMap<SnapshotPtr> found(call_ids.size(), &arena);
+    std::vector<std::int64_t> missing;
+    // Marks of the other consumers on entries dropped as stale.
+    std::vector<std::pair<std::int64_t, std::uint64_t>> stale;
+    {
+        auto state = state_.Lock();
+        const auto everyone = AllConsumers(state->consumers.size());
+        for (auto call_id : call_ids) {
+            auto* entry = state->cache.Get(call_id);
+            if (entry && (entry->taken & bit)) {
+                // Asked for again, e.g. to retry a failed upload: the call
+                // may have changed since the snapshot was read.
+                stale.emplace_back(call_id, entry->taken & ~bit);
+                state->cache.Erase(call_id);
+                entry = nullptr;
+            }
+            if (!entry) {
+                missing.push_back(call_id);
+                continue;
+            }
+            found[call_id] = entry->snapshot;
+            entry->taken |= bit;
+            if ((entry->taken & everyone) == everyone) state->cache.Erase(call_id);
+        }
+    }
+    hits_ += found.Size();
+    misses_ += missing.size();
+
+    if (!missing.empty()) {
+        auto loaded = Load(missing);
+        auto state = state_.Lock();
+        const auto everyone = AllConsumers(state->consumers.size());
+        // The other uploaders take these later; a single consumer never
+        // needs them again.
+        for (auto& snapshot : loaded) {
+            const auto call_id = snapshot->call.id;
+            if (bit != everyone) state->cache.Put(call_id, Entry{snapshot, bit});
+            found[call_id] = std::move(snapshot);
+        }
+        // Consumers that took the stale snapshot don't wait for the new one.
+        for (const auto& [call_id, taken] : stale) {
+            auto* entry = state->cache.Get(call_id);
+            if (!entry) continue;
+            entry->taken |= taken;
+            if ((entry->taken & everyone) == everyone) state->cache.Erase(call_id);
+        }
+    }
+
+    std::vector<SnapshotPtr> result;
+    result.reserve(found.Size());
+    for (auto call_id : call_ids) {
+        if (auto* snapshot = found.Find(call_id); snapshot && *snapshot) result.push_back(std::move(*snapshot));
+    }
+    return result;
+}
+
+std::vector<CallSnapshots::SnapshotPtr> CallSnapshots::Load(const std::vector<std::int64_t>& call_ids) {
+    auto calls_task = userver::utils::Async("call-snapshots-calls", [&] {
+        return timings_.Time(CollectStage::kCalls, [&] { return call_controller_.GetCalls(call_ids); });
+    });
+    auto events_task = userver::utils::Async("call-snapshots-events", [&] {
+        // The CDR formats only look at event types.
+        return timings_.Time(CollectStage::kEvents, [&] {
+            return call_event_controller_.GetEvents(call_ids, controllers::EventFields::kNone);
+        });
+    });
+    auto connections_task = userver::utils::Async("call-snapshots-connections", [&] {
+        return timings_.Time(
+            CollectStage::kConnections, [&] { return connection_controller_.GetConnections(call_ids); });
+    });
+
+    auto calls = calls_task.Get();
+    auto all_events = events_task.Get();
+    auto all_connections = connections_task.Get();
+
+    std::pmr::monotonic_buffer_resource arena{ArenaSize(calls.size())};
+    return AssembleSnapshots(
+        std::move(calls), std::move(all_events), std::move(all_connections), *operator_cache_.Get(), &arena);
+}
+
+} // namespace call_flow_processor::components
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <userver/cache/lru_map.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/concurrent/variable.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "components/controllers/call_controller.hpp"
+#include "components/controllers/call_event_controller.hpp"
+#include "components/controllers/connection_controller.hpp"
+#include "components/caches/operator_cache.hpp"
+#include "models/call_snapshot.hpp"
+
+namespace call_flow_processor::components {
+
+// Stages of building CDRs. kBatch is a whole Collect() call of an
+// uploader; with the reads running concurrently it is close to the slowest
+// stage rather than to their sum.
+enum class CollectStage { kCalls, kEvents, kConnections, kBatch };
+
+inline constexpr std::array<const char*, 4> kCollectStageNames = {"calls", "events", "connections", "batch"};
+
+// Durations per CollectStage, safe to update from concurrent tasks.
+class StageTimings final {
+public:
+    template <class Func>
+    auto Time(CollectStage stage, Func&& func) {
+        const auto start = std::chrono::steady_clock::now();
+        auto result = func();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        auto& timing = timings_[static_cast<std::size_t>(stage)];
+        ++timing.count;
+        timing.total_us += elapsed;
+        timing.last_us = elapsed;
+        return result;
+    }
+
+    // Writes the stages that were timed at least once.
+    void Write(userver::utils::statistics::Writer& writer) const;
+
+private:
+    struct Timing {
+        std::atomic<std::int64_t> count{0};
+        std::atomic<std::int64_t> total_us{0};
+        std::atomic<std::int64_t> last_us{0};
+    };
+
+    std::array<Timing, kCollectStageNames.size()> timings_;
+};
+
+// Shared source of call data for the CDR uploaders running in snapshot
+// collect-mode. The calls, events and connections of a batch are read once,
+// concurrently, and joined with the operator-cache into CallSnapshots that every registered
+// uploader builds its own CDR format from. A snapshot stays cached until
+// each registered uploader has taken it, or until it falls out of the LRU
+// of `capacity` entries, so another CDR format costs no extra reads. An
+// uploader asking for a call it has already taken gets it read afresh.
+class CallSnapshots final : public userver::components::LoggableComponentBase {
+public:
+    static constexpr const char* kName;
+
+    using SnapshotPtr = std::shared_ptr<const models::CallSnapshot>;
+
+    CallSnapshots(const userver::components::ComponentConfig& config,
+                  const userver::components::ComponentContext& context);
+    ~CallSnapshots() override;
+
+    // Called by an uploader from its constructor; the result identifies it
+    // in Get().
+    std::size_t Register(const std::string& uploader);
+
+    // Snapshots of those call_ids that exist, in the order of call_ids.
+    std::vector<SnapshotPtr> Get(std::size_t consumer, const std::vector<std::int64_t>& call_ids);
+
+private:
+    struct Entry {
+        SnapshotPtr snapshot;
+        // Bit i is set once consumer i has taken the snapshot.
+        std::uint64_t taken{0};
+    };
+
+    struct State {
+        explicit State(std::size_t capacity) : cache(capacity) {}
+
+        userver::cache::LruMap<std::int64_t, Entry> cache;
+        std::vector<std::string> consumers;
+    };
+
+    std::vector<SnapshotPtr> Load(const std::vector<std::int64_t>& call_ids);
+
+    controllers::CallController& call_controller_;
+    controllers::CallEventController& call_event_controller_;
+    controllers::ConnectionController& connection_controller_;
+    const caches::OperatorCache& operator_cache_;
+
+    userver::concurrent::Variable<State> state_;
+    StageTimings timings_;
+    std::atomic<std::int64_t> hits_{0};
+    std::atomic<std::int64_t> misses_{0};
+    userver::utils::statistics::Entry statistics_holder_;
+};
+
+} // namespace call_flow_processor::components
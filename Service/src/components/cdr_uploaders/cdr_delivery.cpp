@@ -0,0 +1,107 @@
+#include "cdr_delivery.hpp"
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/utils/rand.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace call_flow_processor::components {
+
+namespace {
+
+bool IsTransient(int status) {
+    return status == 408 || status == 429 || status >= 500;
+}
+
+}  // namespace
+
+DeliverySettings::DeliverySettings(const userver::components::ComponentConfig& config)
+    : chunk_records{config["chunk-records"].As<std::size_t>(500)},
+      chunk_bytes{config["chunk-bytes"].As<std::size_t>(1024 * 1024)},
+      max_in_flight{config["max-in-flight"].As<std::size_t>(4)},
+      timeout{config["request-timeout-ms"].As<std::int64_t>(10000)},
+      attempts{config["request-attempts"].As<int>(3)},
+      retry_delay{config["request-retry-delay-ms"].As<std::int64_t>(200)},
+      max_retry_delay{config["request-max-retry-delay-ms"].As<std::int64_t>(5000)} {
+    if (chunk_records < 1 || max_in_flight < 1 || attempts < 1) {
+        throw std::runtime_error("CDR uploader " + config.Name() +
+                                 ": chunk-records, max-in-flight and request-attempts must be positive");
+    }
+}
+
+CDRDelivery::CDRDelivery(userver::clients::http::Client& http_client, std::string url, DeliverySettings settings)
+    : http_client_(http_client), url_(std::move(url)), settings_(std::move(settings)) {}
+
+DeliveryStatus CDRDelivery::Send(const std::string& content_type, const std::string& body) {
+    auto backoff = settings_.retry_delay;
+    for (int attempt = 1;; ++attempt) {
+        const auto status = Post(content_type, body);
+        if (status && *status >= 200 && *status < 300) {
+            ++delivered_;
+            return DeliveryStatus::kDelivered;
+        }
+        if (status && *status == 415) return DeliveryStatus::kUnsupportedMediaType;
+        if (status && !IsTransient(*status)) {
+            LOG_ERROR() << "CDR sink rejected a chunk: HTTP " << *status;
+            ++failed_;
+            return DeliveryStatus::kRejected;
+        }
+        if (attempt >= settings_.attempts || userver::engine::current_task::IsCancelRequested()) {
+            ++failed_;
+            return DeliveryStatus::kFailed;
+        }
+
+        ++retries_;
+        userver::engine::InterruptibleSleepFor(std::chrono::milliseconds{
+            userver::utils::RandRange(backoff.count() / 2, backoff.count() + 1)});
+        backoff = std::min(backoff * 2, settings_.max_retry_delay);
+    }
+}
+
+void CDRDelivery::ForEach(std::size_t count, const std::function<void(std::size_t)>& deliver) {
+    std::atomic<std::size_t> next{0};
+    std::vector<userver::engine::TaskWithResult<void>> senders;
+    const auto sender_count = std::min(count, settings_.max_in_flight);
+    senders.reserve(sender_count);
+    for (std::size_t i = 0; i < sender_count; ++i) {
+        senders.push_back(userver::utils::Async("cdr-delivery", [&] {
+            for (auto index = next++; index < count; index = next++) deliver(index);
+        }));
+    }
+    for (auto& sender : senders) sender.Get();
+}
+
+void CDRDelivery::Write(userver::utils::statistics::Writer& writer) const {
+    writer["requests"] = requests_.load();
+    writer["retries"] = retries_.load();
+    writer["in-flight"] = in_flight_.load();
+    writer["delivered-chunks"] = delivered_.load();
+    writer["failed-chunks"] = failed_.load();
+}
+
+std::optional<int> CDRDelivery::Post(const std::string& content_type, const std::string& body) {
+    ++requests_;
+    ++in_flight_;
+    try {
+        const auto response = http_client_.CreateRequest()
+            .post(url_)
+            .timeout(settings_.timeout)
+            .header("Content-Type", content_type)
+            .body(body)
+            .perform();
+        --in_flight_;
+        const auto status = static_cast<int>(response->status_code());
+        if (IsTransient(status)) LOG_WARNING() << "CDR sink answered HTTP " << status;
+        return status;
+    } catch (const std::exception& ex) {
+        --in_flight_;
+        LOG_WARNING() << "CDR sink request failed: " << ex.what();
+        return std::nullopt;
+    }
+}
+
+} // namespace call_flow_processor::components
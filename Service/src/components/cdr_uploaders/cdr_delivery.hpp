@@ -0,0 +1,76 @@
+#pragma once
+
+#include <userver/clients/http/client.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace call_flow_processor::components {
+
+// How CDRDelivery splits and sends a batch, from the uploader's config.
+// A batch is delivered while its lease is held, so request-attempts times
+// request-timeout-ms should stay well below lease-ms.
+struct DeliverySettings {
+    explicit DeliverySettings(const userver::components::ComponentConfig& config);
+
+    // A chunk holds at most chunk_records CDRs and, unless it is a single
+    // CDR, at most chunk_bytes of body.
+    std::size_t chunk_records;
+    std::size_t chunk_bytes;
+    std::size_t max_in_flight;
+    std::chrono::milliseconds timeout;
+    // Requests per chunk, the first one included.
+    int attempts;
+    std::chrono::milliseconds retry_delay;
+    std::chrono::milliseconds max_retry_delay;
+};
+
+enum class DeliveryStatus {
+    kDelivered,
+    // The sink does not accept the Content-Type; not retried.
+    kUnsupportedMediaType,
+    // Any other 4xx: the chunk itself is wrong, sending it again won't help.
+    kRejected,
+    // Timeouts, network errors, 408, 429 and 5xx on every attempt.
+    kFailed,
+};
+
+// Sends the chunks of a CDR batch to the sink. Up to max_in_flight chunks
+// are in flight at once. Transient failures are retried within the batch
+// with exponential backoff and jitter; whatever is still failing after
+// that is left to the cdr_upload_info backoff by the caller.
+class CDRDelivery final {
+public:
+    CDRDelivery(userver::clients::http::Client& http_client, std::string url, DeliverySettings settings);
+
+    const DeliverySettings& Settings() const { return settings_; }
+
+    DeliveryStatus Send(const std::string& content_type, const std::string& body);
+
+    // Calls deliver(index) for every index below count from at most
+    // max_in_flight tasks, and returns once all of them are done.
+    void ForEach(std::size_t count, const std::function<void(std::size_t)>& deliver);
+
+    void Write(userver::utils::statistics::Writer& writer) const;
+
+private:
+    // The HTTP status, or std::nullopt if the request timed out or failed.
+    std::optional<int> Post(const std::string& content_type, const std::string& body);
+
+    userver::clients::http::Client& http_client_;
+    const std::string url_;
+    const DeliverySettings settings_;
+
+    std::atomic<std::int64_t> requests_{0};
+    std::atomic<std::int64_t> retries_{0};
+    std::atomic<std::int64_t> in_flight_{0};
+    std::atomic<std::int64_t> delivered_{0};
+    std::atomic<std::int64_t> failed_{0};
+};
+
+} // namespace call_flow_processor::components
@@ -3,40 +3,92 @@
 
 namespace call_flow_processor::components {
 
+namespace {
+
+constexpr const char* kEnqueueFinishedCalls =
+    "WITH horizon AS (SELECT txid_snapshot_xmin(txid_current_snapshot()) AS txid), "
+    "watermark AS ("
+    "SELECT COALESCE((SELECT finished_txid FROM cdr_uploader_watermarks WHERE cdr_uploader_id = $1), 0) AS txid), "
+    "enqueued AS ("
+    "INSERT INTO cdr_upload_info (cdr_type, call_id, upload_status) "
+    "SELECT $1, f.call_id, 'pending' FROM finished_calls f, watermark, horizon "
+    "WHERE f.finished_txid >= watermark.txid AND f.finished_txid < horizon.txid "
+    "ON CONFLICT (cdr_type, call_id) DO NOTHING "
+    "RETURNING call_id), "
+    "advanced AS ("
+    "INSERT INTO cdr_uploader_watermarks (cdr_uploader_id, finished_txid) "
+    "SELECT $1, horizon.txid FROM horizon "
+    "ON CONFLICT (cdr_uploader_id) DO UPDATE "
+    "SET finished_txid = GREATEST(cdr_uploader_watermarks.finished_txid, EXCLUDED.finished_txid)) "
+    "SELECT count(*) FROM enqueued;";
+
+constexpr const char* kClaimPending =
+    "UPDATE cdr_upload_info AS u "
+    "SET lease_owner = $2, lease_until = now() + $4::bigint * interval '1 millisecond' "
+    "FROM ("
+    "SELECT call_id FROM cdr_upload_info "
+    "WHERE cdr_type = $1 AND upload_status = 'pending' AND (lease_until IS NULL OR lease_until < now()) "
+    "ORDER BY call_id LIMIT $3 "
+    "FOR UPDATE SKIP LOCKED) AS claimed "
+    "WHERE u.cdr_type = $1 AND u.call_id = claimed.call_id "
+    "RETURNING u.call_id;";
+
+constexpr const char* kUpsertPending =
+    "INSERT INTO cdr_upload_info (cdr_type, call_id, upload_status) "
+    "SELECT $1, UNNEST($2::bigint[]), 'pending' "
+    "ON CONFLICT (cdr_type, call_id) DO NOTHING;";
+
+constexpr const char* kMarkUploaded =
+    "UPDATE cdr_upload_info "
+    "SET upload_status = 'uploaded', uploaded_at = now(), lease_owner = NULL, lease_until = NULL "
+    "WHERE cdr_type = $1 AND call_id = ANY($2::bigint[]);";
+
+// Only failed uploads count as attempts: a call that could not be built yet
+// is not failing. The next attempt waits retry_delay, doubled per failed
+// attempt up to max_retry_delay; lease_until holds that time.
+constexpr const char* kMarkFailed =
+    "UPDATE cdr_upload_info "
+    "SET attempts = attempts + 1, "
+    "upload_status = CASE WHEN $5 > 0 AND attempts + 1 >= $5 THEN 'failed' ELSE upload_status END, "
+    "lease_owner = NULL, "
+    "lease_until = now() + LEAST($3::bigint * power(2, LEAST(attempts, 20)), $4::bigint) "
+    "* interval '1 millisecond' "
+    "WHERE cdr_type = $1 AND call_id = ANY($2::bigint[]) AND upload_status = 'pending';";
+
+constexpr const char* kMarkFailedNow =
+    "UPDATE cdr_upload_info "
+    "SET attempts = attempts + 1, upload_status = 'failed', lease_owner = NULL, lease_until = NULL "
+    "WHERE cdr_type = $1 AND call_id = ANY($2::bigint[]) AND upload_status = 'pending';";
+
+}  // namespace
+
 const char* CDRUploadInfo::kName = "cdr-upload-info";
 
 CDRUploadInfo::CDRUploadInfo(const userver::components::ComponentConfig& config,
                              const userver::components::ComponentContext& context)
     : userver::components::LoggableComponentBase(config, context),
-      pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()} {}
+      pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()},
+      finished_calls_{context.FindComponent<FinishedCallsChannel>("finished-calls-channel")} {}
 
-std::vector<std::int64_t> CDRUploadInfo::GetFinishedCallIds() const {
-    std::vector<std::int64_t> res;
+std::size_t CDRUploadInfo::EnqueueFinishedCalls(const std::string& cdr_type) {
     try {
         auto result = pg_->Execute(
-            userver::storages::postgres::ClusterHostType::kSlave,
-            "SELECT call_id FROM finished_calls"
+            userver::storages::postgres::ClusterHostType::kMaster,
+            kEnqueueFinishedCalls,
+            cdr_type
         );
-        for (const auto& row : result) {
-            res.push_back(row["call_id"].As<std::int64_t>());
-        }
+        return static_cast<std::size_t>(result.AsSingleRow<std::int64_t>());
     } catch (const std::exception& ex) {
-        LOG_ERROR() << "CDRUploadInfo::GetFinishedCallIds error: " << ex.what();
+        LOG_ERROR() << "CDRUploadInfo::EnqueueFinishedCalls error: " << ex.what();
         throw;
     }
-    return res;
 }
 
 void CDRUploadInfo::BatchStoreFinishedCalls(const std::vector<std::int64_t>& call_ids) {
     if (call_ids.empty()) return;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        trx.Execute(
-            "INSERT INTO finished_calls (call_id) "
-            "SELECT UNNEST($1::bigint[]) "
-            "ON CONFLICT DO NOTHING;",
-            call_ids
-        );
+        BatchStoreFinishedCalls(trx, call_ids);
         trx.Commit();
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CDRUploadInfo::BatchStoreFinishedCalls error: " << ex.what();
@@ -44,14 +96,25 @@ void CDRUploadInfo::BatchStoreFinishedCalls(const std::vector<std::int64_t>& cal
     }
 }
 
-void CDRUploadInfo::UpsertPending(const std::string& cdr_type, std::int64_t call_id) {
+void CDRUploadInfo::BatchStoreFinishedCalls(userver::storages::postgres::Transaction& trx,
+                                            const std::vector<std::int64_t>& call_ids) {
+    if (call_ids.empty()) return;
+    trx.Execute(
+        "INSERT INTO finished_calls (call_id) "
+        "SELECT UNNEST($1::bigint[]) "
+        "ON CONFLICT DO NOTHING;",
+        call_ids
+    );
+    finished_calls_.NotifyInstances(trx);
+}
+
+void CDRUploadInfo::UpsertPending(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids) {
+    if (call_ids.empty()) return;
     try {
         pg_->Execute(
             userver::storages::postgres::ClusterHostType::kMaster,
-            "INSERT INTO cdr_upload_info (cdr_type, call_id, upload_status) "
-            "VALUES ($1, $2, 'pending') "
-            "ON CONFLICT (cdr_type, call_id) DO NOTHING;",
-            cdr_type, call_id
+            kUpsertPending,
+            cdr_type, call_ids
         );
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CDRUploadInfo::UpsertPending error: " << ex.what();
@@ -59,31 +122,28 @@ void CDRUploadInfo::UpsertPending(const std::string& cdr_type, std::int64_t call
     }
 }
 
-std::vector<std::int64_t> CDRUploadInfo::GetPendingCallIds(const std::string& cdr_type, std::size_t limit) {
-    std::vector<std::int64_t> res;
+std::vector<std::int64_t> CDRUploadInfo::ClaimPending(const std::string& cdr_type, const std::string& worker_id,
+                                                       std::size_t limit, std::chrono::milliseconds lease) {
     try {
         auto result = pg_->Execute(
-            userver::storages::postgres::ClusterHostType::kSlave,
-            "SELECT call_id FROM cdr_upload_info WHERE cdr_type = $1 AND upload_status = 'pending' LIMIT $2",
-            cdr_type, static_cast<std::int64_t>(limit)
+            userver::storages::postgres::ClusterHostType::kMaster,
+            kClaimPending,
+            cdr_type, worker_id, static_cast<std::int64_t>(limit), static_cast<std::int64_t>(lease.count())
         );
-        for (const auto& row : result) {
-            res.push_back(row["call_id"].As<std::int64_t>());
-        }
+        return result.AsContainer<std::vector<std::int64_t>>();
     } catch (const std::exception& ex) {
-        LOG_ERROR() << "CDRUploadInfo::GetPendingCallIds error: " << ex.what();
+        LOG_ERROR() << "CDRUploadInfo::ClaimPending error: " << ex.what();
         throw;
     }
-    return res;
 }
 
-void CDRUploadInfo::MarkUploaded(const std::string& cdr_type, std::int64_t call_id) {
+void CDRUploadInfo::MarkUploaded(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids) {
+    if (call_ids.empty()) return;
     try {
         pg_->Execute(
             userver::storages::postgres::ClusterHostType::kMaster,
-            "UPDATE cdr_upload_info SET upload_status = 'uploaded', uploaded_at = now() "
-            "WHERE cdr_type = $1 AND call_id = $2",
-            cdr_type, call_id
+            kMarkUploaded,
+            cdr_type, call_ids
         );
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CDRUploadInfo::MarkUploaded error: " << ex.what();
@@ -91,4 +151,43 @@ void CDRUploadInfo::MarkUploaded(const std::string& cdr_type, std::int64_t call_
     }
 }
 
+void CDRUploadInfo::MarkUploaded(userver::storages::postgres::Transaction& trx,
+                                 const std::string& cdr_type,
+                                 const std::vector<std::int64_t>& call_ids) {
+    if (call_ids.empty()) return;
+    trx.Execute(kMarkUploaded, cdr_type, call_ids);
+}
+
+void CDRUploadInfo::MarkFailed(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids,
+                               const RetryPolicy& retry) {
+    if (call_ids.empty()) return;
+    try {
+        pg_->Execute(
+            userver::storages::postgres::ClusterHostType::kMaster,
+            kMarkFailed,
+            cdr_type, call_ids,
+            static_cast<std::int64_t>(retry.delay.count()),
+            static_cast<std::int64_t>(retry.max_delay.count()),
+            retry.max_attempts
+        );
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "CDRUploadInfo::MarkFailed error: " << ex.what();
+        throw;
+    }
+}
+
+void CDRUploadInfo::MarkFailed(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids) {
+    if (call_ids.empty()) return;
+    try {
+        pg_->Execute(
+            userver::storages::postgres::ClusterHostType::kMaster,
+            kMarkFailedNow,
+            cdr_type, call_ids
+        );
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "CDRUploadInfo::MarkFailed error: " << ex.what();
+        throw;
+    }
+}
+
 } // namespace call_flow_processor::components
@@ -2,11 +2,23 @@
 
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/transaction.hpp>
+#include <chrono>
 #include <vector>
 #include <string>
+#include "components/cdr_uploaders/finished_calls_channel.hpp"
 
 namespace call_flow_processor::components {
 
+// Backoff of failed uploads, see CDRUploadInfo::MarkFailed().
+struct RetryPolicy {
+    std::chrono::milliseconds delay{1000};
+    std::chrono::milliseconds max_delay{300000};
+    // A call that failed this many times is left in status 'failed';
+    // 0 retries forever.
+    int max_attempts{10};
+};
+
 class CDRUploadInfo final : public userver::components::LoggableComponentBase {
 public:
     static constexpr const char* kName;
@@ -14,18 +26,40 @@ public:
     CDRUploadInfo(const userver::components::ComponentConfig& config,
                   const userver::components::ComponentContext& context);
 
-    std::vector<std::int64_t> GetFinishedCallIds() const;
+    // Enqueues as pending the calls that finished since the previous call
+    // for this cdr_type and moves its watermark; returns the number of calls
+    // enqueued. Only rows of transactions older than every running one are
+    // taken, so a slow transaction can't commit a call below the watermark.
+    std::size_t EnqueueFinishedCalls(const std::string& cdr_type);
 
     void BatchStoreFinishedCalls(const std::vector<std::int64_t>& call_ids);
+    // Also notifies the other instances once trx is committed.
+    void BatchStoreFinishedCalls(userver::storages::postgres::Transaction& trx,
+                                 const std::vector<std::int64_t>& call_ids);
+
+    void UpsertPending(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids);
 
-    void UpsertPending(const std::string& cdr_type, std::int64_t call_id);
+    // Leases up to limit pending calls to worker_id. Calls leased by another
+    // worker are skipped until their lease expires.
+    std::vector<std::int64_t> ClaimPending(const std::string& cdr_type, const std::string& worker_id,
+                                           std::size_t limit, std::chrono::milliseconds lease);
 
-    std::vector<std::int64_t> GetPendingCallIds(const std::string& cdr_type, std::size_t limit = 1000);
+    void MarkUploaded(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids);
+    void MarkUploaded(userver::storages::postgres::Transaction& trx,
+                      const std::string& cdr_type,
+                      const std::vector<std::int64_t>& call_ids);
 
-    void MarkUploaded(const std::string& cdr_type, std::int64_t call_id);
+    // Releases the leases of calls whose upload failed and schedules their
+    // next attempt with exponential backoff.
+    void MarkFailed(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids,
+                    const RetryPolicy& retry);
+    // Releases the leases of calls whose upload can never succeed and
+    // leaves them in status 'failed' without further attempts.
+    void MarkFailed(const std::string& cdr_type, const std::vector<std::int64_t>& call_ids);
 
 protected:
     userver::storages::postgres::ClusterPtr pg_;
+    FinishedCallsChannel& finished_calls_;
 };
 
 } // namespace call_flow_processor::components
@@ -1,89 +1,104 @@
 #include "cdr_uploader.hpp"
 #include <userver/logging/log.hpp>
-#include <algorithm>
+#include <userver/storages/postgres/component.hpp>
 
 namespace call_flow_processor::components {
 
+namespace {
+
+// Collect() in one statement: calls without a known operator or not yet
+// finished are skipped, the events of a call come back as an array.
+constexpr const char* kAssembleCDRs =
+    "SELECT c.call_id, c.started_at::timestamptz AS started_at, c.finished_at::timestamptz AS finished_at, "
+    "c.caller_number, c.callee_number, "
+    "trunc(EXTRACT(EPOCH FROM (c.finished_at - c.started_at)))::integer AS duration_sec, "
+    "c.status, COALESCE(ev.event_types, ARRAY[]::text[]) AS event_types "
+    "FROM calls c "
+    "JOIN operators o ON o.operator_id = c.user_id "
+    "LEFT JOIN LATERAL ("
+    "SELECT array_agg(e.event_type::text ORDER BY e.event_id) AS event_types "
+    "FROM call_events e WHERE e.call_id = c.call_id) ev ON true "
+    "WHERE c.call_id = ANY($1) AND c.finished_at IS NOT NULL;";
+
+}  // namespace
+
 const char* CDRUploader::kName = "cdr-uploader";
 
 CDRUploader::CDRUploader(const userver::components::ComponentConfig& config,
                          const userver::components::ComponentContext& context)
     : CDRUploaderBase<models::CDR>(config, context),
-      cdr_controller_(context.FindComponent<controllers::CDRController>("cdr-controller")),
-      call_controller_(context.FindComponent<controllers::CallController>("call-controller")),
-      call_event_controller_(context.FindComponent<controllers::CallEventController>("call-event-controller")),
-      operator_controller_(context.FindComponent<controllers::OperatorController>("operator-controller")),
-      connection_controller_(context.FindComponent<controllers::ConnectionController>("connection-controller"))
+      pg_(context.FindComponent<userver::components::Postgres>("postgres").GetCluster()),
+      cdr_controller_(context.FindComponent<controllers::CDRController>("cdr-controller"))
 {}
 
 std::string CDRUploader::GetId() { return "internal_cdr"; }
 
 std::vector<models::CDR> CDRUploader::Collect(const std::vector<std::int64_t>& call_ids) {
-    std::vector<models::CDR> result;
-    if (call_ids.empty()) return result;
-
-    std::vector<models::Call> calls = call_controller_.GetCalls(call_ids);
-    std::unordered_map<std::int64_t, models::Call> calls_map;
-    for (auto&& call : calls) calls_map[call.id] = std::move(call);
-
-    std::unordered_map<std::int64_t, std::vector<models::CallEvent>> events_map;
-    {
-        auto all_events = call_event_controller_.GetEvents(call_ids);
-        for (auto&& ev : all_events) events_map[ev.call_id].push_back(std::move(ev));
-    }
-
-    std::unordered_map<std::int64_t, std::vector<models::Connection>> conn_map;
-    {
-        auto all_connections = connection_controller_.GetConnections(call_ids);
-        for (auto&& c : all_connections) conn_map[c.call_id].push_back(std::move(c));
-    }
-
-    std::unordered_map<std::int64_t, models::Operator> operator_map;
-    {
-        std::vector<std::int64_t> user_ids;
-        for (const auto& call : calls) user_ids.push_back(call.user_id);
-        user_ids.erase(std::unique(user_ids.begin(), user_ids.end()), user_ids.end());
-        auto all_operators = operator_controller_.GetOperators(user_ids);
-        for (auto&& op : all_operators) operator_map[op.operator_id] = std::move(op);
-    }
-
-    for (auto call_id : call_ids) {
-        auto call_it = calls_map.find(call_id);
-        if (call_it == calls_map.end()) continue;
-        const auto& call = call_it->second;
-
-        auto op_it = operator_map.find(call.user_id);
-        if (op_it == operator_map.end()) continue;
-
-        const auto& events = events_map[call_id];
-        std::vector<std::string> event_types;
-        for (const auto& ev : events) event_types.push_back(ev.event_type);
+    if (call_ids.empty()) return {};
+    if (CurrentCollectMode() == CollectMode::kSql) return CollectInDatabase(call_ids);
+    return CollectFromSnapshots(call_ids);
+}
 
-        models::CDR cdr;
-        cdr.call_id        = std::to_string(call.id);
-        cdr.call_start     = call.started_at;
-        cdr.call_end       = call.finished_at;
-        cdr.caller_number  = call.caller_number;
-        cdr.callee_number  = call.callee_number;
-        cdr.duration_sec   = static_cast<int>((call.finished_at - call.started_at).count());
-        cdr.call_result    = call.status;
-        cdr.call_events    = std::move(event_types);
+std::optional<models::CDR> CDRUploader::Transform(const models::CallSnapshot& snapshot) {
+    // Calls without a known operator or not yet finished are skipped.
+    const auto& call = snapshot.call;
+    if (!snapshot.call_operator || !call.finished_at) return std::nullopt;
+
+    std::vector<models::Symbol> event_types;
+    event_types.reserve(snapshot.events.size());
+    for (const auto& ev : snapshot.events) event_types.push_back(ev.event_type);
+
+    models::CDR cdr;
+    cdr.call_id        = std::to_string(call.id);
+    cdr.call_start     = call.started_at;
+    cdr.call_end       = *call.finished_at;
+    cdr.caller_number  = call.caller_number;
+    cdr.callee_number  = call.callee_number;
+    cdr.duration_sec   = SecondsBetween(call.started_at, *call.finished_at);
+    cdr.call_result    = call.status;
+    cdr.call_events    = std::move(event_types);
+    return cdr;
+}
 
-        result.push_back(std::move(cdr));
+std::vector<models::CDR> CDRUploader::CollectInDatabase(const std::vector<std::int64_t>& call_ids) {
+    std::vector<models::CDR> result;
+    try {
+        const auto res = pg_->Execute(userver::storages::postgres::ClusterHostType::kSlave, kAssembleCDRs, call_ids);
+        result.reserve(res.Size());
+        for (const auto& row : res) {
+            models::CDR cdr;
+            cdr.call_id       = std::to_string(row["call_id"].As<std::int64_t>());
+            cdr.call_start    = row["started_at"].As<userver::storages::postgres::TimePointTz>();
+            cdr.call_end      = row["finished_at"].As<userver::storages::postgres::TimePointTz>();
+            cdr.caller_number = row["caller_number"].As<std::string>();
+            cdr.callee_number = row["callee_number"].As<std::string>();
+            cdr.duration_sec  = row["duration_sec"].As<int>();
+            cdr.call_result   = models::Symbol{row["status"].As<std::string>()};
+            for (const auto& event : row["event_types"].As<std::vector<std::string>>()) {
+                cdr.call_events.emplace_back(event);
+            }
+            result.push_back(std::move(cdr));
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "CDRUploader CollectInDatabase error: " << ex.what();
+        throw;
     }
-
     return result;
 }
 
 void CDRUploader::Upload(std::vector<models::CDR>&& data) {
     if (data.empty()) return;
+    const auto call_ids = CallIdsOf(data);
     try {
-        cdr_controller_.Save(std::move(data));
-        for (const auto& cdr : data) {
-            upload_info_.MarkUploaded(GetId(), std::stoll(cdr.call_id));
-        }
+        // The CDRs and their status are written together, so a call is never
+        // marked uploaded without its CDR or saved twice after a crash.
+        auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+        cdr_controller_.Save(trx, std::move(data));
+        upload_info_.MarkUploaded(trx, GetId(), call_ids);
+        trx.Commit();
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CDRUploader upload batch failed: " << ex.what();
+        MarkFailed(call_ids);
     }
 }
 
@@ -3,15 +3,12 @@
 #include "cdr_uploader_base.hpp"
 #include "models/cdr.hpp"
 #include "components/controllers/cdr_controller.hpp"
-#include "components/controllers/call_controller.hpp"
-#include "components/controllers/call_event_controller.hpp"
-#include "components/controllers/operator_controller.hpp"
-#include "components/controllers/connection_controller.hpp"
 #include "components/cdr_upload_info.hpp"
 
 #include <userver/components/component_config.hpp>
 #include <userver/components/component_context.hpp>
-#include <unordered_map>
+#include <userver/storages/postgres/cluster.hpp>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -28,13 +25,13 @@ protected:
     std::string GetId() override;
     std::vector<models::CDR> Collect(const std::vector<std::int64_t>& call_ids) override;
     void Upload(std::vector<models::CDR>&& data) override;
+    std::optional<models::CDR> Transform(const models::CallSnapshot& snapshot) override;
 
 private:
+    std::vector<models::CDR> CollectInDatabase(const std::vector<std::int64_t>& call_ids);
+
+    userver::storages::postgres::ClusterPtr pg_;
     controllers::CDRController& cdr_controller_;
-    controllers::CallController& call_controller_;
-    controllers::CallEventController& call_event_controller_;
-    controllers::OperatorController& operator_controller_;
-    controllers::ConnectionController& connection_controller_;
 };
 
 } // namespace call_flow_processor::components
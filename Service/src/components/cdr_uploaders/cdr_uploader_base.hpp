@@ -1,51 +1,259 @@
 #pragma once
 
-#include <userver/storages/postgres/dist_lock_component_base.hpp>
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/deadline.hpp>
+#include <userver/engine/single_consumer_event.hpp>
 #include <userver/engine/task/cancel.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/formats/json/inline.hpp>
+#include <userver/formats/json/value.hpp>
 #include <userver/logging/log.hpp>
+#include <userver/testsuite/testpoint.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/utils/uuid4.hpp>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <vector>
 #include <string>
 #include <chrono>
 #include "components/cdr_upload_info.hpp"
+#include "components/cdr_uploaders/call_snapshots.hpp"
+#include "components/cdr_uploaders/finished_calls_channel.hpp"
 
 namespace call_flow_processor::components {
 
+// How an uploader builds its CDRs from the call data:
+//  * kSql      - one statement per batch joins and aggregates everything in
+//                PostgreSQL and returns only the CDR columns;
+//  * kSnapshot - the CDRs are transformed from CallSnapshots, which are read
+//                once through the controllers and shared by all uploaders
+//                in this mode.
+enum class CollectMode { kSql, kSnapshot };
+
+inline CollectMode ParseCollectMode(const std::string& value) {
+    if (value == "sql") return CollectMode::kSql;
+    if (value == "snapshot") return CollectMode::kSnapshot;
+    throw std::runtime_error("Unknown CDR uploader collect-mode: " + value);
+}
+
+// Whole seconds from `from` to `to`, truncated as the SQL collect-mode
+// truncates EXTRACT(EPOCH ...).
+template <class TimePoint>
+int SecondsBetween(const TimePoint& from, const TimePoint& to) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(to - from).count());
+}
+
+// cdr_upload_info is the work queue of the uploader. Every instance runs
+// an intake task, which turns finished calls into pending rows, and
+// `workers` upload workers. A worker claims a batch of pending rows with a
+// lease (FOR UPDATE SKIP LOCKED), builds and uploads their CDRs and marks
+// them uploaded. Rows it could not build keep the lease until it expires
+// and are claimed again afterwards, also by a worker on another instance.
 template <class T>
-class CDRUploaderBase : public userver::storages::postgres::DistLockComponentBase {
+class CDRUploaderBase : public userver::components::LoggableComponentBase {
 protected:
     CDRUploaderBase(
         const userver::components::ComponentConfig& config,
         const userver::components::ComponentContext& context)
-        : userver::storages::postgres::DistLockComponentBase(config, context),
-          upload_info_{context.FindComponent<CDRUploadInfo>("cdr-upload-info")}
-    {}
-
-    void DoWork() override {
-        while (!userver::engine::current_task::IsCancelRequested()) {
-            // 1. Find all finished calls and upsert as pending into cdr_upload_info
-            const auto finished_calls = upload_info_.GetFinishedCallIds();
-            for (const auto& id : finished_calls) {
-                upload_info_.UpsertPending(GetId(), id);
-            }
-
-            // 2. Load pending call_ids to process
-            const auto pending_call_ids = upload_info_.GetPendingCallIds(GetId(), GetBatchSize());
+        : userver::components::LoggableComponentBase(config, context),
+          upload_info_{context.FindComponent<CDRUploadInfo>("cdr-upload-info")},
+          finished_calls_{context.FindComponent<FinishedCallsChannel>("finished-calls-channel")},
+          snapshots_{context.FindComponent<CallSnapshots>("call-snapshots")},
+          batch_size_{config["batch-size"].As<std::size_t>(1000)},
+          poll_interval_{config["poll-interval-ms"].As<std::int64_t>(30000)},
+          lease_{config["lease-ms"].As<std::int64_t>(60000)},
+          collect_mode_{ParseCollectMode(config["collect-mode"].As<std::string>("sql"))},
+          retry_{std::chrono::milliseconds{config["retry-delay-ms"].As<std::int64_t>(1000)},
+                 std::chrono::milliseconds{config["max-retry-delay-ms"].As<std::int64_t>(300000)},
+                 config["max-attempts"].As<int>(10)},
+          workers_count_{config["workers"].As<int>(2)},
+          instance_id_{userver::utils::generators::GenerateUuid()} {
+        if (workers_count_ < 1) {
+            throw std::runtime_error("CDR uploader " + config.Name() + ": workers must be positive");
+        }
+        if (collect_mode_ == CollectMode::kSnapshot) snapshot_consumer_ = snapshots_.Register(config.Name());
 
-            // 3. Try to collect all needed data for each call_id and build CDRs
-            auto output = Collect(pending_call_ids);
+        statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>()
+            .GetStorage()
+            .RegisterWriter(
+                "cdr-uploader-collect",
+                [this](userver::utils::statistics::Writer& writer) { timings_.Write(writer); },
+                {{"uploader", config.Name()}});
+    }
 
-            // 4. Upload those we could build
-            Upload(output);
+    ~CDRUploaderBase() override {
+        statistics_holder_.Unregister();
+        StopTasks();
+    }
 
-            userver::engine::InterruptibleSleepFor(std::chrono::seconds(5));
+    // Workers call into the derived uploader, so they are started only once
+    // every component is constructed.
+    void OnAllComponentsLoaded() override {
+        for (int index = 0; index < workers_count_; ++index) {
+            auto worker = std::make_unique<Worker>();
+            worker->id = instance_id_ + "-" + std::to_string(index);
+            workers_.push_back(std::move(worker));
+        }
+        for (auto& worker : workers_) {
+            Worker& target = *worker;
+            worker->task = userver::utils::CriticalAsync(GetId() + "-worker", [this, &target] { RunWorker(target); });
         }
+        intake_task_ = userver::utils::CriticalAsync(GetId() + "-intake", [this] { RunIntake(); });
     }
 
+    void OnAllComponentsAreStopping() override { StopTasks(); }
+
     virtual std::string GetId() = 0;
     virtual std::vector<T> Collect(const std::vector<std::int64_t>& call_ids) = 0;
     virtual void Upload(std::vector<T>&&) = 0;
+    // Builds the CDR of one call in snapshot collect-mode; std::nullopt
+    // skips the call.
+    virtual std::optional<T> Transform(const models::CallSnapshot& snapshot) = 0;
+
+    // collect-mode of the next batch. Tests may switch it through the
+    // cdr-uploader-collect-mode testpoint to compare both modes; snapshot
+    // mode needs the uploader to be configured for it.
+    CollectMode CurrentCollectMode() {
+        auto mode = collect_mode_;
+        TESTPOINT_CALLBACK(
+            "cdr-uploader-collect-mode",
+            userver::formats::json::MakeObject("uploader", GetId()),
+            [&mode, this](const userver::formats::json::Value& json) {
+                if (!json.HasMember("mode")) return;
+                const auto requested = ParseCollectMode(json["mode"].As<std::string>());
+                if (requested == CollectMode::kSql || snapshot_consumer_) mode = requested;
+            });
+        return mode;
+    }
+
+    std::vector<T> CollectFromSnapshots(const std::vector<std::int64_t>& call_ids) {
+        std::vector<T> result;
+        for (const auto& snapshot : snapshots_.Get(*snapshot_consumer_, call_ids)) {
+            if (auto cdr = Transform(*snapshot)) result.push_back(std::move(*cdr));
+        }
+        return result;
+    }
+
+    static std::vector<std::int64_t> CallIdsOf(const std::vector<T>& data) {
+        std::vector<std::int64_t> call_ids;
+        call_ids.reserve(data.size());
+        for (const auto& cdr : data) call_ids.push_back(std::stoll(cdr.call_id));
+        return call_ids;
+    }
+
+    // Failing to record this only leaves the batch to its lease expiry,
+    // so errors are logged and not rethrown.
+    void MarkFailed(const std::vector<std::int64_t>& call_ids) {
+        try {
+            upload_info_.MarkFailed(GetId(), call_ids, retry_);
+        } catch (const std::exception& e) {
+            LOG_ERROR() << "CDR uploader " << GetId() << " could not record failed uploads: " << e.what();
+        }
+    }
+
+    // For uploads the receiver refused: retrying them cannot succeed.
+    void MarkRejected(const std::vector<std::int64_t>& call_ids) {
+        try {
+            upload_info_.MarkFailed(GetId(), call_ids);
+        } catch (const std::exception& e) {
+            LOG_ERROR() << "CDR uploader " << GetId() << " could not record rejected uploads: " << e.what();
+        }
+    }
 
     CDRUploadInfo& upload_info_;
+    FinishedCallsChannel& finished_calls_;
+    CallSnapshots& snapshots_;
+    const std::size_t batch_size_;
+    const std::chrono::milliseconds poll_interval_;
+    const std::chrono::milliseconds lease_;
+    const CollectMode collect_mode_;
+    const RetryPolicy retry_;
+
+private:
+    struct Worker {
+        std::string id;
+        userver::engine::SingleConsumerEvent wakeup;
+        userver::engine::TaskWithResult<void> task;
+    };
+
+    // Calls finished in this instance arrive through FinishedCallsChannel and
+    // are enqueued right away. Calls finished by other instances are picked
+    // up by the watermark sweep, which runs on their NOTIFY and every
+    // poll_interval_ as a fallback.
+    void RunIntake() {
+        const auto subscription = finished_calls_.Subscribe(GetId());
+        auto next_sweep = userver::engine::Deadline::Passed();
+        while (!userver::engine::current_task::IsCancelRequested()) {
+            try {
+                if (subscription->TakePollRequest() || next_sweep.IsReached()) {
+                    upload_info_.EnqueueFinishedCalls(GetId());
+                    next_sweep = userver::engine::Deadline::FromDuration(poll_interval_);
+                    WakeWorkers();
+                }
+
+                const auto call_ids = subscription->PopBatch(batch_size_, next_sweep);
+                if (call_ids.empty()) continue;
+                upload_info_.UpsertPending(GetId(), call_ids);
+                WakeWorkers();
+            } catch (const std::exception& e) {
+                if (userver::engine::current_task::IsCancelRequested()) break;
+                // The sweep enqueues whatever was lost here.
+                LOG_ERROR() << "CDR uploader " << GetId() << " intake failed: " << e.what();
+                next_sweep = userver::engine::Deadline::FromDuration(poll_interval_);
+            }
+        }
+    }
+
+    void RunWorker(Worker& worker) {
+        while (!userver::engine::current_task::IsCancelRequested()) {
+            std::size_t claimed = 0;
+            try {
+                // 1. Claim pending call_ids nobody else holds a lease on
+                const auto call_ids = upload_info_.ClaimPending(GetId(), worker.id, batch_size_, lease_);
+                claimed = call_ids.size();
+
+                // 2. Try to collect all needed data for each call_id and build CDRs
+                auto output = timings_.Time(CollectStage::kBatch, [&] { return Collect(call_ids); });
+
+                // 3. Upload those we could build
+                Upload(std::move(output));
+            } catch (const std::exception& e) {
+                LOG_ERROR() << "CDR uploader " << worker.id << " batch failed: " << e.what();
+            }
+
+            // A full batch means there is likely more; otherwise wait for
+            // the intake or for expired leases.
+            if (claimed < batch_size_) {
+                [[maybe_unused]] const bool woken = worker.wakeup.WaitForEventFor(poll_interval_);
+            }
+        }
+    }
+
+    void WakeWorkers() {
+        for (auto& worker : workers_) worker->wakeup.Send();
+    }
+
+    void StopTasks() {
+        if (intake_task_.IsValid()) intake_task_.SyncCancel();
+        for (auto& worker : workers_) {
+            if (worker->task.IsValid()) worker->task.SyncCancel();
+        }
+        workers_.clear();
+    }
+
+    const int workers_count_;
+    const std::string instance_id_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    userver::engine::TaskWithResult<void> intake_task_;
+    std::optional<std::size_t> snapshot_consumer_;
+    StageTimings timings_;
+    userver::utils::statistics::Entry statistics_holder_;
 };
 
 } // namespace call_flow_processor::components
@@ -1,137 +1,218 @@
 #include "external_cdr_uploader.hpp"
+#include "parsers/binary_batch.hpp"
+#include "parsers/json_writer.hpp"
+#include <userver/components/statistics_storage.hpp>
 #include <userver/logging/log.hpp>
+#include <userver/storages/postgres/component.hpp>
 #include <algorithm>
+#include <iterator>
 #include <optional>
 
 namespace call_flow_processor::components {
 
+namespace {
+
+// A typical CDR takes a little over 200 bytes of JSON, so most bodies are
+// written without regrowing the buffer.
+constexpr std::size_t kJsonBytesPerCDR = 256;
+
+std::string ToJson(const std::vector<models::ExternalCDR>& data) {
+    std::string body;
+    body.reserve(data.size() * kJsonBytesPerCDR);
+    parsers::WriteJson(data, body);
+    return body;
+}
+
+// Collect() in one statement. The answered/hangup flags are aggregated over
+// the call's events, wait and talk times come from its first connection.
+// Calls not yet finished are skipped.
+constexpr const char* kAssembleExternalCDRs =
+    "SELECT c.call_id, c.started_at::timestamptz AS started_at, c.finished_at::timestamptz AS finished_at, "
+    "c.caller_number, o.operator_id::text AS operator_id, o.name AS operator_name, "
+    "CASE WHEN ev.answered THEN 'ANSWERED' ELSE 'NO_ANSWER' END AS agent_status, "
+    "COALESCE(trunc(EXTRACT(EPOCH FROM (fc.answered_at - fc.initiated_at)))::integer, 0) AS wait_sec, "
+    "COALESCE(trunc(EXTRACT(EPOCH FROM (fc.finished_at - fc.answered_at)))::integer, 0) AS talk_sec, "
+    "CASE WHEN ev.hung_up THEN 'COMPLETED' ELSE c.status END AS end_reason "
+    "FROM calls c "
+    "LEFT JOIN operators o ON o.operator_id = c.user_id "
+    "LEFT JOIN LATERAL ("
+    "SELECT bool_or(e.event_type = 'answered') AS answered, bool_or(e.event_type = 'hangup') AS hung_up "
+    "FROM call_events e WHERE e.call_id = c.call_id) ev ON true "
+    "LEFT JOIN LATERAL ("
+    "SELECT x.initiated_at, x.answered_at, x.finished_at FROM connections x "
+    "WHERE x.call_id = c.call_id ORDER BY x.connection_id LIMIT 1) fc ON true "
+    "WHERE c.call_id = ANY($1) AND c.finished_at IS NOT NULL;";
+
+}  // namespace
+
 const char* ExternalCDRUploader::kName = "external-cdr-uploader";
 
 ExternalCDRUploader::ExternalCDRUploader(
     const userver::components::ComponentConfig& config,
     const userver::components::ComponentContext& context)
     : CDRUploaderBase<models::ExternalCDR>(config, context),
-      call_controller_(context.FindComponent<controllers::CallController>("call-controller")),
-      call_event_controller_(context.FindComponent<controllers::CallEventController>("call-event-controller")),
-      operator_controller_(context.FindComponent<controllers::OperatorController>("operator-controller")),
-      connection_controller_(context.FindComponent<controllers::ConnectionController>("connection-controller")),
-      http_client_(context.FindComponent<userver::clients::http::Client>("http-client")),
-      upload_url_(config["upload-url"].As<std::string>())
-{}
+      pg_(context.FindComponent<userver::components::Postgres>("postgres").GetCluster()),
+      delivery_(context.FindComponent<userver::components::HttpClient>("http-client").GetHttpClient(),
+                config["upload-url"].As<std::string>(),
+                DeliverySettings{config}),
+      binary_upload_(config["upload-format"].As<std::string>("json") == "binary")
+{
+    delivery_statistics_ = context.FindComponent<userver::components::StatisticsStorage>()
+        .GetStorage()
+        .RegisterWriter(
+            "cdr-delivery",
+            [this](userver::utils::statistics::Writer& writer) { delivery_.Write(writer); },
+            {{"uploader", config.Name()}});
+}
+
+ExternalCDRUploader::~ExternalCDRUploader() { delivery_statistics_.Unregister(); }
 
 std::string ExternalCDRUploader::GetId() { return "external_cdr"; }
 
 std::vector<models::ExternalCDR> ExternalCDRUploader::Collect(const std::vector<std::int64_t>& call_ids) {
-    std::vector<models::ExternalCDR> result;
-    if (call_ids.empty()) return result;
-
-    std::vector<models::Call> calls = call_controller_.GetCalls(call_ids);
-    std::unordered_map<std::int64_t, models::Call> calls_map;
-    for (auto&& call : calls) calls_map[call.id] = std::move(call);
-
-    auto all_events = call_event_controller_.GetEvents(call_ids);
-    std::unordered_map<std::int64_t, std::vector<models::CallEvent>> events_map;
-    for (auto&& ev : all_events) events_map[ev.call_id].push_back(std::move(ev));
-
-    auto all_connections = connection_controller_.GetConnections(call_ids);
-    std::unordered_map<std::int64_t, std::vector<models::Connection>> conn_map;
-    for (auto&& c : all_connections) conn_map[c.call_id].push_back(std::move(c));
-
-    std::vector<std::int64_t> user_ids;
-    for (const auto& call : calls) user_ids.push_back(call.user_id);
-    user_ids.erase(std::unique(user_ids.begin(), user_ids.end()), user_ids.end());
-    auto all_operators = operator_controller_.GetOperators(user_ids);
-    std::unordered_map<std::int64_t, models::Operator> operator_map;
-    for (auto&& op : all_operators) operator_map[op.operator_id] = std::move(op);
-
-    for (auto call_id : call_ids) {
-        auto call_it = calls_map.find(call_id);
-        if (call_it == calls_map.end()) continue;
-        const auto& call = call_it->second;
-
-        std::optional<std::string> operator_id;
-        std::optional<std::string> operator_name;
-        auto op_it = operator_map.find(call.user_id);
-        if (op_it != operator_map.end()) {
-            operator_id = std::to_string(op_it->second.operator_id);
-            operator_name = op_it->second.name;
-        }
+    if (call_ids.empty()) return {};
+    if (CurrentCollectMode() == CollectMode::kSql) return CollectInDatabase(call_ids);
+    return CollectFromSnapshots(call_ids);
+}
 
-        std::string agent_status = "NO_ANSWER";
-        int wait_sec = 0;
-        int talk_sec = 0;
-        std::string end_reason = "";
+std::optional<models::ExternalCDR> ExternalCDRUploader::Transform(const models::CallSnapshot& snapshot) {
+    const auto& call = snapshot.call;
+    if (!call.finished_at) return std::nullopt;
 
-        const auto& events = events_map[call_id];
-        for (const auto& ev : events) {
-            if (ev.event_type == "answered") agent_status = "ANSWERED";
-            if (ev.event_type == "hangup") end_reason = "COMPLETED";
-        }
+    std::optional<std::string> operator_id;
+    std::optional<std::string> operator_name;
+    if (snapshot.call_operator) {
+        operator_id = std::to_string(snapshot.call_operator->operator_id);
+        operator_name = snapshot.call_operator->name;
+    }
 
-        const auto& conns = conn_map[call_id];
-        if (!conns.empty()) {
-            auto conn = conns.front();
-            if (conn.answered_at && conn.initiated_at) {
-                wait_sec = static_cast<int>((conn.answered_at.value() - conn.initiated_at).count());
-            }
-            if (conn.finished_at && conn.answered_at) {
-                talk_sec = static_cast<int>((conn.finished_at.value() - conn.answered_at.value()).count());
-            }
-        }
+    std::string agent_status = "NO_ANSWER";
+    int wait_sec = 0;
+    int talk_sec = 0;
+    std::string end_reason = "";
+
+    for (const auto& ev : snapshot.events) {
+        if (ev.event_type == models::symbols::kAnswered) agent_status = "ANSWERED";
+        if (ev.event_type == models::symbols::kHangup) end_reason = "COMPLETED";
+    }
 
-        models::ExternalCDR cdr;
-        cdr.call_id        = std::to_string(call.id);
-        cdr.call_start     = call.started_at;
-        cdr.call_end       = call.finished_at;
-        cdr.caller_number  = call.caller_number;
-        cdr.operator_id    = operator_id;
-        cdr.operator_name  = operator_name;
-        cdr.agent_status   = agent_status;
-        cdr.wait_sec       = wait_sec;
-        cdr.talk_sec       = talk_sec;
-        cdr.end_reason     = end_reason.empty() ? call.status : end_reason;
-
-        result.push_back(std::move(cdr));
+    if (!snapshot.connections.empty()) {
+        const auto& conn = snapshot.connections.front();
+        if (conn.answered_at) wait_sec = SecondsBetween(conn.initiated_at, *conn.answered_at);
+        if (conn.finished_at && conn.answered_at) talk_sec = SecondsBetween(*conn.answered_at, *conn.finished_at);
     }
 
+    models::ExternalCDR cdr;
+    cdr.call_id        = std::to_string(call.id);
+    cdr.call_start     = call.started_at;
+    cdr.call_end       = *call.finished_at;
+    cdr.caller_number  = call.caller_number;
+    cdr.operator_id    = operator_id;
+    cdr.operator_name  = operator_name;
+    cdr.agent_status   = agent_status;
+    cdr.wait_sec       = wait_sec;
+    cdr.talk_sec       = talk_sec;
+    cdr.end_reason     = end_reason.empty() ? call.status.Str() : end_reason;
+    return cdr;
+}
+
+std::vector<models::ExternalCDR> ExternalCDRUploader::CollectInDatabase(const std::vector<std::int64_t>& call_ids) {
+    std::vector<models::ExternalCDR> result;
+    try {
+        const auto res = pg_->Execute(
+            userver::storages::postgres::ClusterHostType::kSlave, kAssembleExternalCDRs, call_ids);
+        result.reserve(res.Size());
+        for (const auto& row : res) {
+            models::ExternalCDR cdr;
+            cdr.call_id       = std::to_string(row["call_id"].As<std::int64_t>());
+            cdr.call_start    = row["started_at"].As<userver::storages::postgres::TimePointTz>();
+            cdr.call_end      = row["finished_at"].As<userver::storages::postgres::TimePointTz>();
+            cdr.caller_number = row["caller_number"].As<std::string>();
+            cdr.operator_id   = row["operator_id"].As<std::optional<std::string>>();
+            cdr.operator_name = row["operator_name"].As<std::optional<std::string>>();
+            cdr.agent_status  = row["agent_status"].As<std::string>();
+            cdr.wait_sec      = row["wait_sec"].As<int>();
+            cdr.talk_sec      = row["talk_sec"].As<int>();
+            cdr.end_reason    = row["end_reason"].As<std::string>();
+            result.push_back(std::move(cdr));
+        }
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "ExternalCDRUploader CollectInDatabase error: " << ex.what();
+        throw;
+    }
     return result;
 }
 
 void ExternalCDRUploader::Upload(std::vector<models::ExternalCDR>&& data) {
     if (data.empty()) return;
-    userver::formats::json::ValueBuilder arr;
-    for (const auto& cdr : data) {
-        userver::formats::json::ValueBuilder ob;
-        ob["call_id"] = cdr.call_id;
-        ob["call_start"] = userver::formats::json::ValueBuilder(cdr.call_start.TimePoint().time_since_epoch().count());
-        ob["call_end"] = userver::formats::json::ValueBuilder(cdr.call_end.TimePoint().time_since_epoch().count());
-        ob["caller_number"] = cdr.caller_number;
-        if (cdr.operator_id) ob["operator_id"] = cdr.operator_id.value();
-        if (cdr.operator_name) ob["operator_name"] = cdr.operator_name.value();
-        ob["agent_status"] = cdr.agent_status;
-        ob["wait_sec"] = cdr.wait_sec;
-        ob["talk_sec"] = cdr.talk_sec;
-        ob["end_reason"] = cdr.end_reason;
-        arr.PushBack(ob.ExtractValue());
+    const bool binary = binary_upload_;
+    const auto chunk_records = delivery_.Settings().chunk_records;
+
+    std::vector<Chunk> chunks;
+    for (std::size_t begin = 0; begin < data.size(); begin += chunk_records) {
+        const auto end = std::min(begin + chunk_records, data.size());
+        AddChunks(chunks,
+                  {std::make_move_iterator(data.begin() + begin), std::make_move_iterator(data.begin() + end)},
+                  binary);
+    }
+    delivery_.ForEach(chunks.size(), [&](std::size_t index) { Deliver(chunks[index]); });
+}
+
+ExternalCDRUploader::Chunk ExternalCDRUploader::Encode(std::vector<models::ExternalCDR>&& items, bool binary) const {
+    Chunk chunk;
+    chunk.items = std::move(items);
+    if (binary) {
+        chunk.content_type = std::string{parsers::kBinaryBatchContentType};
+        chunk.body = parsers::EncodeBatch(chunk.items);
+    } else {
+        chunk.content_type = std::string{parsers::kJsonContentType};
+        chunk.body = ToJson(chunk.items);
+    }
+    return chunk;
+}
+
+void ExternalCDRUploader::AddChunks(std::vector<Chunk>& chunks, std::vector<models::ExternalCDR>&& items,
+                                    bool binary) const {
+    auto chunk = Encode(std::move(items), binary);
+    if (chunk.body.size() <= delivery_.Settings().chunk_bytes || chunk.items.size() == 1) {
+        chunks.push_back(std::move(chunk));
+        return;
     }
+    const auto middle = chunk.items.begin() + chunk.items.size() / 2;
+    std::vector<models::ExternalCDR> second{std::make_move_iterator(middle), std::make_move_iterator(chunk.items.end())};
+    chunk.items.erase(middle, chunk.items.end());
+    AddChunks(chunks, std::move(chunk.items), binary);
+    AddChunks(chunks, std::move(second), binary);
+}
+
+void ExternalCDRUploader::Deliver(Chunk& chunk) {
+    const auto call_ids = CallIdsOf(chunk.items);
     try {
-        auto response = http_client_.CreateRequest()
-            .post(upload_url_)
-            .timeout(std::chrono::seconds(10))
-            .header("Content-Type", "application/json")
-            .body(userver::formats::json::ToString(arr.ExtractValue()))
-            .perform();
-
-        if (response->status_code == userver::clients::http::HttpStatus::kOk ||
-            response->status_code == userver::clients::http::HttpStatus::kCreated) {
-            for (const auto& cdr : data) {
-                upload_info_.MarkUploaded(GetId(), std::stoll(cdr.call_id));
-            }
+        const auto status = delivery_.Send(chunk.content_type, chunk.body);
+
+        // A receiver that does not know the binary format gets JSON from now
+        // on. JSON bodies are larger, so the CDRs are split into chunks anew.
+        if (status == DeliveryStatus::kUnsupportedMediaType && chunk.content_type != parsers::kJsonContentType) {
+            LOG_WARNING() << "CDR receiver does not accept binary batches, switching to JSON";
+            binary_upload_ = false;
+            std::vector<Chunk> json_chunks;
+            AddChunks(json_chunks, std::move(chunk.items), false);
+            for (auto& json_chunk : json_chunks) Deliver(json_chunk);
+            return;
+        }
+
+        if (status == DeliveryStatus::kDelivered) {
+            upload_info_.MarkUploaded(GetId(), call_ids);
+        } else if (status == DeliveryStatus::kRejected) {
+            LOG_ERROR() << "ExternalCDRUploader: the receiver rejected " << call_ids.size() << " CDRs, not retrying";
+            MarkRejected(call_ids);
         } else {
-            LOG_ERROR() << "ExternalCDRUploader POST failed: HTTP " << response->status_code;
+            LOG_ERROR() << "ExternalCDRUploader could not deliver " << call_ids.size() << " CDRs";
+            MarkFailed(call_ids);
         }
     } catch (const std::exception& ex) {
-        LOG_ERROR() << "ExternalCDRUploader upload batch exception: " << ex.what();
+        LOG_ERROR() << "ExternalCDRUploader upload chunk exception: " << ex.what();
+        MarkFailed(call_ids);
     }
 }
 
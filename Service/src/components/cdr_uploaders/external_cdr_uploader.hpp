@@ -1,43 +1,63 @@
 #pragma once
 
 #include "cdr_uploader_base.hpp"
+#include "cdr_delivery.hpp"
 #include "models/external_cdr.hpp"
-#include "components/controllers/call_controller.hpp"
-#include "components/controllers/call_event_controller.hpp"
-#include "components/controllers/operator_controller.hpp"
-#include "components/controllers/connection_controller.hpp"
 #include "components/cdr_upload_info.hpp"
 
 #include <userver/components/component_config.hpp>
 #include <userver/components/component_context.hpp>
 #include <userver/clients/http/component.hpp>
 #include <userver/clients/http/client.hpp>
-#include <userver/formats/json/value_builder.hpp>
-#include <unordered_map>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <atomic>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace call_flow_processor::components {
 
+// Uploads are delivered by CDRDelivery: a batch is split into chunks by
+// chunk-records and chunk-bytes, which are sent concurrently and retried
+// on transient failures. Every chunk is marked uploaded or failed in
+// cdr_upload_info on its own.
 class ExternalCDRUploader final : public CDRUploaderBase<models::ExternalCDR> {
 public:
     static constexpr const char* kName;
 
     ExternalCDRUploader(const userver::components::ComponentConfig& config,
                         const userver::components::ComponentContext& context);
+    ~ExternalCDRUploader() override;
 
 protected:
     std::string GetId() override;
     std::vector<models::ExternalCDR> Collect(const std::vector<std::int64_t>& call_ids) override;
     void Upload(std::vector<models::ExternalCDR>&& data) override;
+    std::optional<models::ExternalCDR> Transform(const models::CallSnapshot& snapshot) override;
 
 private:
-    controllers::CallController& call_controller_;
-    controllers::CallEventController& call_event_controller_;
-    controllers::OperatorController& operator_controller_;
-    controllers::ConnectionController& connection_controller_;
-    userver::clients::http::Client& http_client_;
-    std::string upload_url_;
+    struct Chunk {
+        std::vector<models::ExternalCDR> items;
+        std::string content_type;
+        std::string body;
+    };
+
+    std::vector<models::ExternalCDR> CollectInDatabase(const std::vector<std::int64_t>& call_ids);
+    Chunk Encode(std::vector<models::ExternalCDR>&& items, bool binary) const;
+    // Appends items as one chunk, or halves it until the bodies fit
+    // chunk-bytes.
+    void AddChunks(std::vector<Chunk>& chunks, std::vector<models::ExternalCDR>&& items, bool binary) const;
+    // Sends a chunk and marks its calls. Retries are left to CDRDelivery.
+    void Deliver(Chunk& chunk);
+
+    userver::storages::postgres::ClusterPtr pg_;
+    CDRDelivery delivery_;
+    // upload-format: binary sends parsers::EncodeBatch() bodies; cleared
+    // once the receiver answers 415.
+    std::atomic<bool> binary_upload_;
+    userver::utils::statistics::Entry delivery_statistics_;
 };
 
 } // namespace call_flow_processor::components
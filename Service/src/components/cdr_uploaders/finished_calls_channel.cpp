@@ -0,0 +1,172 @@
+#include "finished_calls_channel.hpp"
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/storages/postgres/component.hpp>
+#include <userver/storages/postgres/exceptions.hpp>
+#include <userver/storages/postgres/notify.hpp>
+#include <userver/utils/async.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/utils/uuid4.hpp>
+
+namespace call_flow_processor::components {
+
+namespace {
+
+constexpr const char* kNotifyChannel = "finished_calls";
+
+// Queued in place of a call id to wake a subscriber blocked in PopBatch().
+constexpr std::int64_t kPollRequest = -1;
+
+}  // namespace
+
+const char* FinishedCallsChannel::kName = "finished-calls-channel";
+
+FinishedCallsChannel::FinishedCallsChannel(const userver::components::ComponentConfig& config,
+                                           const userver::components::ComponentContext& context)
+    : userver::components::LoggableComponentBase(config, context),
+      pg_(context.FindComponent<userver::components::Postgres>("postgres").GetCluster()),
+      queue_size_(config["queue-size"].As<std::size_t>(10000)),
+      max_stall_(config["max-stall-ms"].As<std::int64_t>(1000)),
+      instance_id_(userver::utils::generators::GenerateUuid()) {
+    statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>()
+        .GetStorage()
+        .RegisterWriter(
+            "finished-calls-channel",
+            [this](userver::utils::statistics::Writer& writer) {
+                writer["notifications-received"] = notifications_received_.load();
+                const auto subscribers = subscribers_.Lock();
+                for (const auto& [uploader_id, subscriber] : *subscribers) {
+                    writer["depth"].ValueWithLabels(
+                        subscriber->queue->GetSizeApproximate(), {"uploader", uploader_id});
+                    writer["published"].ValueWithLabels(subscriber->published.load(), {"uploader", uploader_id});
+                    writer["dropped"].ValueWithLabels(subscriber->dropped.load(), {"uploader", uploader_id});
+                    writer["stall-ms"].ValueWithLabels(subscriber->stall_ms.load(), {"uploader", uploader_id});
+                }
+            });
+
+    if (config["listen-notifications"].As<bool>(true)) {
+        listener_task_ = userver::utils::CriticalAsync("finished-calls-listener", [this] { Listen(); });
+    }
+}
+
+FinishedCallsChannel::~FinishedCallsChannel() {
+    if (listener_task_.IsValid()) listener_task_.SyncCancel();
+    statistics_holder_.Unregister();
+}
+
+std::unique_ptr<FinishedCallsChannel::Subscription> FinishedCallsChannel::Subscribe(const std::string& uploader_id) {
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->queue = Queue::Create(queue_size_ + 1);
+    subscriber->poll_requested = std::make_shared<std::atomic<bool>>(false);
+    subscribers_.Lock()->insert_or_assign(uploader_id, subscriber);
+    return std::unique_ptr<Subscription>(
+        new Subscription(*this, uploader_id, subscriber->queue, subscriber->poll_requested));
+}
+
+void FinishedCallsChannel::Unsubscribe(const std::string& uploader_id, const std::shared_ptr<Queue>& queue) {
+    auto subscribers = subscribers_.Lock();
+    const auto it = subscribers->find(uploader_id);
+    if (it != subscribers->end() && it->second->queue == queue) subscribers->erase(it);
+}
+
+void FinishedCallsChannel::Publish(const std::vector<std::int64_t>& call_ids) {
+    if (call_ids.empty()) return;
+
+    std::vector<std::shared_ptr<Subscriber>> subscribers;
+    {
+        const auto locked = subscribers_.Lock();
+        for (const auto& [uploader_id, subscriber] : *locked) subscribers.push_back(subscriber);
+    }
+
+    for (const auto& subscriber : subscribers) {
+        auto producer = subscriber->queue->GetMultiProducer();
+        const auto deadline = userver::engine::Deadline::FromDuration(max_stall_);
+        std::size_t pushed = 0;
+        for (; pushed < call_ids.size(); ++pushed) {
+            auto call_id = call_ids[pushed];
+            if (producer.PushNoblock(std::move(call_id))) continue;
+
+            const auto stall_started = std::chrono::steady_clock::now();
+            const bool accepted = producer.Push(std::move(call_id), deadline);
+            subscriber->stall_ms += std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - stall_started).count();
+            if (!accepted) break;
+        }
+        subscriber->published += pushed;
+        if (pushed < call_ids.size()) {
+            subscriber->dropped += call_ids.size() - pushed;
+            LOG_WARNING() << "Finished calls queue stayed full for " << max_stall_.count()
+                          << "ms, " << call_ids.size() - pushed << " calls are left to the database poll";
+        }
+    }
+}
+
+void FinishedCallsChannel::NotifyInstances(userver::storages::postgres::Transaction& trx) {
+    // Identical notifications of one transaction are folded by PostgreSQL.
+    trx.Execute("SELECT pg_notify($1, $2);", std::string{kNotifyChannel}, instance_id_);
+}
+
+void FinishedCallsChannel::Listen() {
+    while (!userver::engine::current_task::IsCancelRequested()) {
+        try {
+            auto scope = pg_->Listen(kNotifyChannel);
+            while (!userver::engine::current_task::IsCancelRequested()) {
+                try {
+                    const auto notification = scope.WaitNotify(userver::engine::Deadline::FromDuration(
+                        std::chrono::seconds(5)));
+                    ++notifications_received_;
+                    if (notification.payload != instance_id_) RequestPoll();
+                } catch (const userver::storages::postgres::ConnectionTimeoutError&) {
+                    // No notifications yet, keep listening.
+                }
+            }
+        } catch (const std::exception& e) {
+            if (userver::engine::current_task::IsCancelRequested()) break;
+            // Subscribers still poll on their own schedule meanwhile.
+            LOG_ERROR() << "FinishedCallsChannel listen failed: " << e.what();
+            userver::engine::InterruptibleSleepFor(std::chrono::seconds(1));
+        }
+    }
+}
+
+void FinishedCallsChannel::RequestPoll() {
+    const auto subscribers = subscribers_.Lock();
+    for (const auto& [uploader_id, subscriber] : *subscribers) {
+        if (subscriber->poll_requested->exchange(true)) continue;
+        // Queues are created one slot larger than queue-size, so unless the
+        // uploader is already busy draining a full queue this wakes it up;
+        // in that case it sees the flag after the current batch anyway.
+        subscriber->queue->GetMultiProducer().PushNoblock(std::int64_t{kPollRequest});
+    }
+}
+
+FinishedCallsChannel::Subscription::Subscription(
+    FinishedCallsChannel& channel, std::string uploader_id, std::shared_ptr<Queue> queue,
+    std::shared_ptr<std::atomic<bool>> poll_requested)
+    : channel_(channel),
+      uploader_id_(std::move(uploader_id)),
+      queue_(std::move(queue)),
+      poll_requested_(std::move(poll_requested)),
+      consumer_(queue_->GetConsumer()) {}
+
+FinishedCallsChannel::Subscription::~Subscription() { channel_.Unsubscribe(uploader_id_, queue_); }
+
+std::vector<std::int64_t> FinishedCallsChannel::Subscription::PopBatch(
+    std::size_t max_size, userver::engine::Deadline deadline) {
+    std::vector<std::int64_t> call_ids;
+    std::int64_t call_id = 0;
+    if (!consumer_.Pop(call_id, deadline)) return call_ids;
+    if (call_id == kPollRequest) return call_ids;
+    call_ids.push_back(call_id);
+    while (call_ids.size() < max_size && consumer_.PopNoblock(call_id)) {
+        if (call_id == kPollRequest) break;
+        call_ids.push_back(call_id);
+    }
+    return call_ids;
+}
+
+bool FinishedCallsChannel::Subscription::TakePollRequest() { return poll_requested_->exchange(false); }
+
+} // namespace call_flow_processor::components
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/concurrent/queue.hpp>
+#include <userver/concurrent/variable.hpp>
+#include <userver/engine/deadline.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/transaction.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace call_flow_processor::components {
+
+// In-process hand-off of newly finished calls from the ingest side (data
+// fetchers, ingest handlers) to the CDR uploaders running in this instance.
+//
+// Every active uploader has a bounded MPSC queue. Publish() pushes each call
+// id to all of them and blocks while a queue is full, which slows the
+// producers down to the pace of the slowest uploader. A producer waits at
+// most max-stall-ms per queue; after that the id is left to the uploader's
+// database poll, since finished_calls stays the source of truth. Uploaders
+// that run on another instance never subscribe here and are not waited for.
+//
+// Other instances learn about new finished calls through a PostgreSQL
+// NOTIFY sent with the transaction that recorded them. The channel LISTENs
+// for it and asks every local subscriber to poll the database right away.
+class FinishedCallsChannel final : public userver::components::LoggableComponentBase {
+public:
+    static constexpr const char* kName;
+
+    using Queue = userver::concurrent::MpscQueue<std::int64_t>;
+
+    FinishedCallsChannel(const userver::components::ComponentConfig& config,
+                         const userver::components::ComponentContext& context);
+    ~FinishedCallsChannel() override;
+
+    // Queue of one uploader; it receives ids only while the subscription
+    // is alive.
+    class Subscription final {
+    public:
+        Subscription(Subscription&&) = delete;
+        ~Subscription();
+
+        // Waits until deadline for the first id, then takes whatever else
+        // is queued, up to max_size ids.
+        // Returns early, possibly empty, when a database poll is requested.
+        std::vector<std::int64_t> PopBatch(std::size_t max_size, userver::engine::Deadline deadline);
+
+        // True once after another instance has recorded finished calls.
+        bool TakePollRequest();
+
+    private:
+        friend class FinishedCallsChannel;
+        Subscription(FinishedCallsChannel& channel, std::string uploader_id, std::shared_ptr<Queue> queue,
+                     std::shared_ptr<std::atomic<bool>> poll_requested);
+
+        FinishedCallsChannel& channel_;
+        const std::string uploader_id_;
+        std::shared_ptr<Queue> queue_;
+        std::shared_ptr<std::atomic<bool>> poll_requested_;
+        Queue::Consumer consumer_;
+    };
+
+    std::unique_ptr<Subscription> Subscribe(const std::string& uploader_id);
+
+    // Called once the transaction that recorded the calls is committed.
+    void Publish(const std::vector<std::int64_t>& call_ids);
+
+    // Sends the cross-instance NOTIFY; it is delivered on commit of trx.
+    void NotifyInstances(userver::storages::postgres::Transaction& trx);
+
+private:
+    struct Subscriber {
+        std::shared_ptr<Queue> queue;
+        std::shared_ptr<std::atomic<bool>> poll_requested;
+        std::atomic<std::int64_t> published{0};
+        std::atomic<std::int64_t> dropped{0};
+        std::atomic<std::int64_t> stall_ms{0};
+    };
+
+    void Unsubscribe(const std::string& uploader_id, const std::shared_ptr<Queue>& queue);
+    void Listen();
+    void RequestPoll();
+
+    userver::storages::postgres::ClusterPtr pg_;
+    const std::size_t queue_size_;
+    const std::chrono::milliseconds max_stall_;
+    // Identifies this instance in NOTIFY payloads, own notifications are
+    // skipped since local subscribers already got the ids through Publish().
+    const std::string instance_id_;
+    std::atomic<std::int64_t> notifications_received_{0};
+    userver::concurrent::Variable<std::map<std::string, std::shared_ptr<Subscriber>>, userver::engine::Mutex>
+        subscribers_;
+    userver::utils::statistics::Entry statistics_holder_;
+    userver::engine::TaskWithResult<void> listener_task_;
+};
+
+} // namespace call_flow_processor::components
@@ -0,0 +1,55 @@
+#include "snapshot_assembly.hpp"
+
+namespace call_flow_processor::components {
+
+namespace {
+
+struct Group {
+    models::CallSnapshot* snapshot{nullptr};
+    std::size_t events{0};
+    std::size_t connections{0};
+};
+
+}  // namespace
+
+std::vector<std::shared_ptr<const models::CallSnapshot>> AssembleSnapshots(
+    std::vector<models::Call>&& calls,
+    std::vector<models::CallEvent>&& events,
+    std::vector<models::Connection>&& connections,
+    const std::unordered_map<std::int64_t, models::Operator>& operators,
+    std::pmr::memory_resource* arena) {
+    std::vector<std::shared_ptr<const models::CallSnapshot>> result;
+    result.reserve(calls.size());
+    FlatIdMap<Group> groups(calls.size(), arena);
+
+    for (auto& call : calls) {
+        auto snapshot = std::make_shared<models::CallSnapshot>();
+        const auto op_it = operators.find(call.user_id);
+        if (op_it != operators.end()) snapshot->call_operator = op_it->second;
+        snapshot->call = std::move(call);
+        groups[snapshot->call.id].snapshot = snapshot.get();
+        result.push_back(std::move(snapshot));
+    }
+
+    for (const auto& ev : events) {
+        if (auto* group = groups.Find(ev.call_id)) ++group->events;
+    }
+    for (const auto& c : connections) {
+        if (auto* group = groups.Find(c.call_id)) ++group->connections;
+    }
+    for (const auto& snapshot : result) {
+        const auto* group = groups.Find(snapshot->call.id);
+        group->snapshot->events.reserve(group->events);
+        group->snapshot->connections.reserve(group->connections);
+    }
+
+    for (auto& ev : events) {
+        if (auto* group = groups.Find(ev.call_id)) group->snapshot->events.push_back(std::move(ev));
+    }
+    for (auto& c : connections) {
+        if (auto* group = groups.Find(c.call_id)) group->snapshot->connections.push_back(std::move(c));
+    }
+    return result;
+}
+
+} // namespace call_flow_processor::components
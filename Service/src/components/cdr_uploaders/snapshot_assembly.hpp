@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "models/call_snapshot.hpp"
+
+namespace call_flow_processor::components {
+
+// Open-addressing hash map from an id to V, for maps that live as long as
+// one batch. Slots are probed linearly and kept at most half full, and
+// their storage comes from the given memory resource, so with a
+// monotonic arena the whole map is one allocation that is released
+// together with the rest of the batch.
+template <class V>
+class FlatIdMap final {
+public:
+    FlatIdMap(std::size_t expected_size, std::pmr::memory_resource* resource)
+        : slots_(CapacityFor(expected_size), resource), mask_(slots_.size() - 1) {}
+
+    // Inserts a value-initialized V when key is absent.
+    V& operator[](std::int64_t key) {
+        if ((size_ + 1) * 2 > slots_.size()) Grow();
+        auto& slot = Probe(key);
+        if (!slot.used) {
+            slot.used = true;
+            slot.key = key;
+            ++size_;
+        }
+        return slot.value;
+    }
+
+    V* Find(std::int64_t key) {
+        auto& slot = Probe(key);
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    std::size_t Size() const { return size_; }
+
+private:
+    struct Slot {
+        std::int64_t key{0};
+        bool used{false};
+        V value{};
+    };
+
+    static std::size_t CapacityFor(std::size_t expected_size) {
+        std::size_t capacity = 16;
+        while (capacity < expected_size * 2) capacity <<= 1;
+        return capacity;
+    }
+
+    static std::size_t Hash(std::int64_t key) {
+        auto hash = static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+        return static_cast<std::size_t>(hash ^ (hash >> 32));
+    }
+
+    Slot& Probe(std::int64_t key) {
+        auto index = Hash(key) & mask_;
+        while (slots_[index].used && slots_[index].key != key) index = (index + 1) & mask_;
+        return slots_[index];
+    }
+
+    void Grow() {
+        std::pmr::vector<Slot> old(slots_.size() * 2, slots_.get_allocator());
+        old.swap(slots_);
+        mask_ = slots_.size() - 1;
+        for (auto& slot : old) {
+            if (!slot.used) continue;
+            auto& target = Probe(slot.key);
+            target = std::move(slot);
+        }
+    }
+
+    std::pmr::vector<Slot> slots_;
+    std::size_t mask_;
+    std::size_t size_{0};
+};
+
+// Groups the rows read for one batch into a snapshot per call, in the order
+// of calls; events and connections of calls not in `calls` are dropped.
+// Each snapshot's vectors are sized exactly before the rows are moved in,
+// and the grouping index is allocated from arena.
+std::vector<std::shared_ptr<const models::CallSnapshot>> AssembleSnapshots(
+    std::vector<models::Call>&& calls,
+    std::vector<models::CallEvent>&& events,
+    std::vector<models::Connection>&& connections,
+    const std::unordered_map<std::int64_t, models::Operator>& operators,
+    std::pmr::memory_resource* arena);
+
+} // namespace call_flow_processor::components
@@ -0,0 +1,136 @@
+#include <benchmark/benchmark.h>
+
+#include "snapshot_assembly.hpp"
+
+#include "benchmarks/allocations.hpp"
+
+#include <string>
+#include <vector>
+
+namespace call_flow_processor::components {
+
+namespace {
+
+constexpr std::size_t kEventsPerCall = 8;
+constexpr std::size_t kConnectionsPerCall = 2;
+
+struct Batch {
+    std::vector<models::Call> calls;
+    std::vector<models::CallEvent> events;
+    std::vector<models::Connection> connections;
+    std::unordered_map<std::int64_t, models::Operator> operators;
+};
+
+// Rows come back from the controllers ordered by primary key, so the
+// events and connections of one call are spread over the batch.
+Batch MakeBatch(std::size_t calls) {
+    Batch batch;
+    for (std::size_t i = 0; i < calls; ++i) {
+        models::Call call{};
+        call.id = static_cast<std::int64_t>(100000 + i);
+        call.status = models::Symbol{"completed"};
+        call.caller_number = "+19998887766";
+        call.callee_number = "+19998880000";
+        call.user_id = static_cast<std::int64_t>(i % 50);
+        batch.calls.push_back(std::move(call));
+    }
+    for (std::size_t j = 0; j < kEventsPerCall; ++j) {
+        for (std::size_t i = 0; i < calls; ++i) {
+            models::CallEvent ev{};
+            ev.event_id = static_cast<std::int64_t>(j * calls + i);
+            ev.call_id = static_cast<std::int64_t>(100000 + i);
+            ev.event_type = j + 1 == kEventsPerCall ? models::symbols::kHangup : models::symbols::kAnswered;
+            batch.events.push_back(std::move(ev));
+        }
+    }
+    for (std::size_t j = 0; j < kConnectionsPerCall; ++j) {
+        for (std::size_t i = 0; i < calls; ++i) {
+            models::Connection c{};
+            c.connection_id = static_cast<std::int64_t>(j * calls + i);
+            c.call_id = static_cast<std::int64_t>(100000 + i);
+            c.phone = "+19998887766";
+            batch.connections.push_back(std::move(c));
+        }
+    }
+    for (std::int64_t id = 0; id < 50; ++id) {
+        batch.operators.emplace(id, models::Operator{id, "Alice Cooper", "100", "alice@test.com"});
+    }
+    return batch;
+}
+
+// The grouping CallSnapshots::Load() did before AssembleSnapshots(): a node
+// per call in an unordered_map and vectors grown one row at a time.
+std::vector<std::shared_ptr<const models::CallSnapshot>> AssembleSnapshotsUnorderedMap(
+    std::vector<models::Call>&& calls,
+    std::vector<models::CallEvent>&& events,
+    std::vector<models::Connection>&& connections,
+    const std::unordered_map<std::int64_t, models::Operator>& operators) {
+    std::unordered_map<std::int64_t, std::shared_ptr<models::CallSnapshot>> snapshots;
+    for (auto&& call : calls) {
+        auto snapshot = std::make_shared<models::CallSnapshot>();
+        auto op_it = operators.find(call.user_id);
+        if (op_it != operators.end()) snapshot->call_operator = op_it->second;
+        snapshot->call = std::move(call);
+        snapshots.emplace(snapshot->call.id, std::move(snapshot));
+    }
+    for (auto&& ev : events) {
+        auto it = snapshots.find(ev.call_id);
+        if (it != snapshots.end()) it->second->events.push_back(std::move(ev));
+    }
+    for (auto&& c : connections) {
+        auto it = snapshots.find(c.call_id);
+        if (it != snapshots.end()) it->second->connections.push_back(std::move(c));
+    }
+    std::vector<std::shared_ptr<const models::CallSnapshot>> result;
+    result.reserve(snapshots.size());
+    for (auto& [call_id, snapshot] : snapshots) result.push_back(std::move(snapshot));
+    return result;
+}
+
+// Runs assemble on a fresh copy of the batch per iteration; only the
+// assembly itself is timed and counted.
+template <class Assemble>
+void RunAssembly(benchmark::State& state, Assemble assemble) {
+    const auto batch = MakeBatch(state.range(0));
+    std::size_t counted = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto calls = batch.calls;
+        auto events = batch.events;
+        auto connections = batch.connections;
+        const auto before = benchmarks::AllocationCount();
+        state.ResumeTiming();
+
+        auto snapshots = assemble(std::move(calls), std::move(events), std::move(connections), batch.operators);
+        benchmark::DoNotOptimize(snapshots);
+
+        state.PauseTiming();
+        counted += benchmarks::AllocationCount() - before;
+        snapshots.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["allocs_per_batch"] = benchmark::Counter(
+        static_cast<double>(counted), benchmark::Counter::kAvgIterations);
+}
+
+}  // namespace
+
+void SnapshotAssemblyUnorderedMap(benchmark::State& state) {
+    RunAssembly(state, [](auto&& calls, auto&& events, auto&& connections, const auto& operators) {
+        return AssembleSnapshotsUnorderedMap(
+            std::move(calls), std::move(events), std::move(connections), operators);
+    });
+}
+BENCHMARK(SnapshotAssemblyUnorderedMap)->RangeMultiplier(10)->Range(10, 1000);
+
+void SnapshotAssemblyFlatArena(benchmark::State& state) {
+    RunAssembly(state, [](auto&& calls, auto&& events, auto&& connections, const auto& operators) {
+        std::pmr::monotonic_buffer_resource arena{calls.size() * 256};
+        return AssembleSnapshots(
+            std::move(calls), std::move(events), std::move(connections), operators, &arena);
+    });
+}
+BENCHMARK(SnapshotAssemblyFlatArena)->RangeMultiplier(10)->Range(10, 1000);
+
+}  // namespace call_flow_processor::components
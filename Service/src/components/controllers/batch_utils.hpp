@@ -0,0 +1,30 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace call_flow_processor::components::controllers {
+
+// A single INSERT ... ON CONFLICT DO UPDATE cannot touch the same row twice,
+// so batches are reduced to the last occurrence of every key first. This
+// keeps the "last row wins" semantics of the old row-by-row upserts.
+template <class T, class KeyFn>
+void KeepLastByKey(std::vector<T>& rows, KeyFn&& key) {
+    using Key = std::decay_t<decltype(key(rows.front()))>;
+    if (rows.size() < 2) return;
+
+    std::unordered_set<Key> seen;
+    seen.reserve(rows.size());
+    std::vector<T> unique;
+    unique.reserve(rows.size());
+    for (auto it = rows.rbegin(); it != rows.rend(); ++it) {
+        if (seen.insert(key(*it)).second) unique.push_back(std::move(*it));
+    }
+    std::reverse(unique.begin(), unique.end());
+    rows = std::move(unique);
+}
+
+}  // namespace call_flow_processor::components::controllers
@@ -1,8 +1,48 @@
 #include "call_controller.hpp"
+#include "batch_utils.hpp"
 #include <userver/logging/log.hpp>
+#include <optional>
 
 namespace call_flow_processor::components::controllers {
 
+namespace {
+
+constexpr const char* kUpsertCalls =
+    "INSERT INTO calls "
+    "(call_id, status, started_at, finished_at, caller_number, callee_number, user_id) "
+    "SELECT * FROM UNNEST("
+    "$1::bigint[], $2::varchar[], $3::timestamptz[], $4::timestamptz[], "
+    "$5::varchar[], $6::varchar[], $7::bigint[]) "
+    "ON CONFLICT (call_id) DO UPDATE SET "
+    "status=EXCLUDED.status, started_at=EXCLUDED.started_at, finished_at=EXCLUDED.finished_at, "
+    "caller_number=EXCLUDED.caller_number, callee_number=EXCLUDED.callee_number, user_id=EXCLUDED.user_id;";
+
+constexpr const char* kStageCalls =
+    "INSERT INTO calls_staging "
+    "(call_id, status, started_at, finished_at, caller_number, callee_number, user_id) "
+    "SELECT * FROM UNNEST("
+    "$1::bigint[], $2::varchar[], $3::timestamptz[], $4::timestamptz[], "
+    "$5::varchar[], $6::varchar[], $7::bigint[]);";
+
+constexpr const char* kMergeStagedCalls =
+    "INSERT INTO calls "
+    "(call_id, status, started_at, finished_at, caller_number, callee_number, user_id) "
+    "SELECT DISTINCT ON (call_id) call_id, status, started_at, finished_at, caller_number, callee_number, user_id "
+    "FROM calls_staging ORDER BY call_id, staged_seq DESC "
+    "ON CONFLICT (call_id) DO UPDATE SET "
+    "status=EXCLUDED.status, started_at=EXCLUDED.started_at, finished_at=EXCLUDED.finished_at, "
+    "caller_number=EXCLUDED.caller_number, callee_number=EXCLUDED.callee_number, user_id=EXCLUDED.user_id;";
+
+constexpr const char* kSelectCalls =
+    "SELECT call_id, status, started_at, finished_at, caller_number, callee_number, user_id "
+    "FROM calls WHERE call_id = ANY($1)";
+
+constexpr const char* kSelectCall =
+    "SELECT call_id, status, started_at, finished_at, caller_number, callee_number, user_id "
+    "FROM calls WHERE call_id = $1";
+
+}  // namespace
+
 const char* CallController::kName = "call-controller";
 
 CallController::CallController(
@@ -17,23 +57,7 @@ void CallController::Save(std::vector<models::Call> &&calls) {
     if (calls.empty()) return;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        for (const auto& call : calls) {
-            trx.Execute(
-                "INSERT INTO calls "
-                "(id, status, started_at, finished_at, caller_number, callee_number, user_id) "
-                "VALUES ($1, $2, $3, $4, $5, $6, $7) "
-                "ON CONFLICT (id) DO UPDATE SET "
-                "status=EXCLUDED.status, started_at=EXCLUDED.started_at, finished_at=EXCLUDED.finished_at, "
-                "caller_number=EXCLUDED.caller_number, callee_number=EXCLUDED.callee_number, user_id=EXCLUDED.user_id;",
-                call.id,
-                call.status,
-                call.started_at,
-                call.finished_at,
-                call.caller_number,
-                call.callee_number,
-                call.user_id
-            );
-        }
+        Save(trx, std::move(calls));
         trx.Commit();
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CallController Save error: " << ex.what();
@@ -41,21 +65,81 @@ void CallController::Save(std::vector<models::Call> &&calls) {
     }
 }
 
+void CallController::Save(userver::storages::postgres::Transaction& trx, std::vector<models::Call>&& calls) {
+    if (calls.empty()) return;
+    KeepLastByKey(calls, [](const models::Call& call) { return call.id; });
+    ExecuteBatch(trx, kUpsertCalls, std::move(calls));
+}
+
+void CallController::Stage(std::vector<models::Call>&& calls) {
+    if (calls.empty()) return;
+    try {
+        auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+        ExecuteBatch(trx, kStageCalls, std::move(calls));
+        trx.Commit();
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "CallController Stage error: " << ex.what();
+        throw;
+    }
+}
+
+void CallController::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    trx.Execute(kMergeStagedCalls);
+    trx.Execute("TRUNCATE calls_staging;");
+}
+
+void CallController::ExecuteBatch(
+    userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::Call>&& calls) {
+    std::vector<std::int64_t> ids;
+    std::vector<std::string> statuses;
+    std::vector<userver::storages::postgres::TimePointTz> started_at;
+    std::vector<std::optional<userver::storages::postgres::TimePointTz>> finished_at;
+    std::vector<std::string> caller_numbers;
+    std::vector<std::string> callee_numbers;
+    std::vector<std::int64_t> user_ids;
+    ids.reserve(calls.size());
+    statuses.reserve(calls.size());
+    started_at.reserve(calls.size());
+    finished_at.reserve(calls.size());
+    caller_numbers.reserve(calls.size());
+    callee_numbers.reserve(calls.size());
+    user_ids.reserve(calls.size());
+
+    for (auto& call : calls) {
+        ids.push_back(call.id);
+        statuses.push_back(call.status.Str());
+        started_at.push_back(call.started_at);
+        finished_at.push_back(call.finished_at);
+        caller_numbers.push_back(std::move(call.caller_number));
+        callee_numbers.push_back(std::move(call.callee_number));
+        user_ids.push_back(call.user_id);
+    }
+
+    trx.Execute(
+        query,
+        ids,
+        statuses,
+        started_at,
+        finished_at,
+        caller_numbers,
+        callee_numbers,
+        user_ids
+    );
+}
+
 std::vector<models::Call> CallController::GetCalls(const std::vector<std::int64_t>& call_ids) {
     std::vector<models::Call> result;
     if (call_ids.empty()) return result;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kSlave);
-        auto res = trx.Execute(
-            "SELECT id, status, started_at, finished_at, caller_number, callee_number, user_id "
-            "FROM calls WHERE id = ANY($1)", call_ids);
+        auto res = trx.Execute(kSelectCalls, call_ids);
 
         for (const auto& row : res) {
             models::Call call;
-            call.id = row["id"].As<std::int64_t>();
-            call.status = row["status"].As<std::string>();
+            call.id = row["call_id"].As<std::int64_t>();
+            call.status = models::Symbol{row["status"].As<std::string>()};
             call.started_at = row["started_at"].As<userver::storages::postgres::TimePointTz>();
-            call.finished_at = row["finished_at"].As<userver::storages::postgres::TimePointTz>();
+            call.finished_at = row["finished_at"].As<std::optional<userver::storages::postgres::TimePointTz>>();
             call.caller_number = row["caller_number"].As<std::string>();
             call.callee_number = row["callee_number"].As<std::string>();
             call.user_id = row["user_id"].As<std::int64_t>();
@@ -72,19 +156,17 @@ std::vector<models::Call> CallController::GetCalls(const std::vector<std::int64_
 models::Call CallController::GetCall(std::int64_t call_id) {
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kSlave);
-        auto res = trx.Execute(
-            "SELECT id, status, started_at, finished_at, caller_number, callee_number, user_id "
-            "FROM calls WHERE id = $1", call_id);
+        auto res = trx.Execute(kSelectCall, call_id);
 
         if (res.IsEmpty())
             throw std::runtime_error("Call not found for id=" + std::to_string(call_id));
 
         auto row = res.Front();
         models::Call call;
-        call.id = row["id"].As<std::int64_t>();
-        call.status = row["status"].As<std::string>();
+        call.id = row["call_id"].As<std::int64_t>();
+        call.status = models::Symbol{row["status"].As<std::string>()};
         call.started_at = row["started_at"].As<userver::storages::postgres::TimePointTz>();
-        call.finished_at = row["finished_at"].As<userver::storages::postgres::TimePointTz>();
+        call.finished_at = row["finished_at"].As<std::optional<userver::storages::postgres::TimePointTz>>();
         call.caller_number = row["caller_number"].As<std::string>();
         call.callee_number = row["callee_number"].As<std::string>();
         call.user_id = row["user_id"].As<std::int64_t>();
@@ -3,6 +3,7 @@
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/storages/postgres/database.hpp>
 #include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/transaction.hpp>
 #include <vector>
 #include <string>
 #include "models/call.hpp"
@@ -19,10 +20,22 @@ public:
     );
 
     void Save(std::vector<models::Call> &&calls);
+    // Writes within the caller's transaction, e.g. together with a fetcher cursor.
+    void Save(userver::storages::postgres::Transaction& trx, std::vector<models::Call>&& calls);
+
+    // Bulk-load path: Stage() appends to calls_staging without conflict checks,
+    // MergeStaged() upserts everything staged so far and empties the table
+    // within the caller's transaction.
+    void Stage(std::vector<models::Call>&& calls);
+    void MergeStaged(userver::storages::postgres::Transaction& trx);
+
     std::vector<models::Call> GetCalls(const std::vector<std::int64_t> &call_ids);
     models::Call GetCall(std::int64_t call_id);
 
 protected:
+    void ExecuteBatch(
+        userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::Call>&& calls);
+
     const userver::storages::postgres::ClusterPtr pg_;
 };
 
@@ -1,8 +1,44 @@
 #include "call_event_controller.hpp"
-#include <userver/formats/json.hpp>
+#include "batch_utils.hpp"
+#include <optional>
 
 namespace call_flow_processor::components::controllers {
 
+namespace {
+
+constexpr const char* kUpsertEvents =
+    "INSERT INTO call_events (event_id, call_id, event_type, payload) "
+    "SELECT u.event_id, u.call_id, u.event_type, u.payload::jsonb "
+    "FROM UNNEST($1::bigint[], $2::bigint[], $3::varchar[], $4::text[]) "
+    "AS u(event_id, call_id, event_type, payload) "
+    "ON CONFLICT(event_id) DO UPDATE "
+    "SET call_id=EXCLUDED.call_id, event_type=EXCLUDED.event_type, payload=EXCLUDED.payload;";
+
+constexpr const char* kStageEvents =
+    "INSERT INTO call_events_staging (event_id, call_id, event_type, payload) "
+    "SELECT u.event_id, u.call_id, u.event_type, u.payload::jsonb "
+    "FROM UNNEST($1::bigint[], $2::bigint[], $3::varchar[], $4::text[]) "
+    "AS u(event_id, call_id, event_type, payload);";
+
+constexpr const char* kMergeStagedEvents =
+    "WITH merged AS ("
+    "INSERT INTO call_events (event_id, call_id, event_type, payload) "
+    "SELECT DISTINCT ON (event_id) event_id, call_id, event_type, payload "
+    "FROM call_events_staging ORDER BY event_id, staged_seq DESC "
+    "ON CONFLICT(event_id) DO UPDATE "
+    "SET call_id=EXCLUDED.call_id, event_type=EXCLUDED.event_type, payload=EXCLUDED.payload "
+    "RETURNING call_id, event_type) "
+    "SELECT DISTINCT call_id FROM merged WHERE event_type = 'hangup';";
+
+constexpr const char* kSelectEvents =
+    "SELECT event_id, call_id, event_type FROM call_events WHERE call_id = ANY($1) ORDER BY event_id";
+
+constexpr const char* kSelectEventsWithPayload =
+    "SELECT event_id, call_id, event_type, payload::text AS payload FROM call_events WHERE call_id = ANY($1) "
+    "ORDER BY event_id";
+
+}  // namespace
+
 const char* CallEventController::kName = "call-event-controller";
 
 CallEventController::CallEventController(
@@ -11,54 +47,108 @@ CallEventController::CallEventController(
 )
 : userver::components::LoggableComponentBase(config, context),
   pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()},
-  cdr_upload_info_(context.FindComponent<components::CDRUploadInfo>("cdr-upload-info"))
+  cdr_upload_info_(context.FindComponent<components::CDRUploadInfo>("cdr-upload-info")),
+  finished_calls_(context.FindComponent<components::FinishedCallsChannel>("finished-calls-channel"))
 {}
 
 void CallEventController::Save(std::vector<models::CallEvent>&& events) {
     if (events.empty()) return;
+    std::vector<std::int64_t> finished_call_ids;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        std::vector<std::int64_t> finished_call_ids;
-        for (const auto& event : events) {
-            trx.Execute(
-                "INSERT INTO call_events (event_id, call_id, event_type, payload) "
-                "VALUES ($1, $2, $3, $4) "
-                "ON CONFLICT(event_id) DO UPDATE "
-                "SET call_id=EXCLUDED.call_id, event_type=EXCLUDED.event_type, payload=EXCLUDED.payload;",
-                event.event_id,
-                event.call_id,
-                event.event_type,
-                userver::formats::json::ToString(event.payload)
-            );
-            if (event.event_type == "hangup") {
-                finished_call_ids.push_back(event.call_id);
-            }
-        }
+        finished_call_ids = Save(trx, std::move(events));
         trx.Commit();
-        if (!finished_call_ids.empty()) {    
-            cdr_upload_info_.BatchStoreFinishedCalls(finished_call_ids);
-        }
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CallEventController Save error: " << ex.what();
         throw;
     }
+    finished_calls_.Publish(finished_call_ids);
+}
+
+std::vector<std::int64_t> CallEventController::Save(
+    userver::storages::postgres::Transaction& trx, std::vector<models::CallEvent>&& events) {
+    if (events.empty()) return {};
+    KeepLastByKey(events, [](const models::CallEvent& event) { return event.event_id; });
+
+    std::vector<std::int64_t> finished_call_ids;
+    for (const auto& event : events) {
+        if (event.event_type == models::symbols::kHangup) {
+            finished_call_ids.push_back(event.call_id);
+        }
+    }
+
+    ExecuteBatch(trx, kUpsertEvents, std::move(events));
+    if (!finished_call_ids.empty()) {
+        cdr_upload_info_.BatchStoreFinishedCalls(trx, finished_call_ids);
+    }
+    return finished_call_ids;
+}
+
+void CallEventController::Stage(std::vector<models::CallEvent>&& events) {
+    if (events.empty()) return;
+    try {
+        auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+        ExecuteBatch(trx, kStageEvents, std::move(events));
+        trx.Commit();
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "CallEventController Stage error: " << ex.what();
+        throw;
+    }
+}
+
+std::vector<std::int64_t> CallEventController::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    auto res = trx.Execute(kMergeStagedEvents);
+    trx.Execute("TRUNCATE call_events_staging;");
+
+    const auto finished_call_ids = res.AsContainer<std::vector<std::int64_t>>();
+    if (!finished_call_ids.empty()) {
+        cdr_upload_info_.BatchStoreFinishedCalls(trx, finished_call_ids);
+    }
+    return finished_call_ids;
+}
+
+void CallEventController::ExecuteBatch(
+    userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::CallEvent>&& events) {
+    std::vector<std::int64_t> event_ids;
+    std::vector<std::int64_t> call_ids;
+    std::vector<std::string> event_types;
+    std::vector<std::string> payloads;
+    event_ids.reserve(events.size());
+    call_ids.reserve(events.size());
+    event_types.reserve(events.size());
+    payloads.reserve(events.size());
+
+    for (auto& event : events) {
+        event_ids.push_back(event.event_id);
+        call_ids.push_back(event.call_id);
+        event_types.push_back(event.event_type.Str());
+        payloads.push_back(std::move(event.payload));
+    }
+
+    trx.Execute(
+        query,
+        event_ids,
+        call_ids,
+        event_types,
+        payloads
+    );
 }
 
-std::vector<models::CallEvent> CallEventController::GetEvents(const std::vector<std::int64_t>& call_ids) {
+std::vector<models::CallEvent> CallEventController::GetEvents(
+    const std::vector<std::int64_t>& call_ids, EventFields fields) {
     std::vector<models::CallEvent> result;
     if (call_ids.empty()) return result;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        auto res = trx.Execute(
-            "SELECT event_id, call_id, event_type, payload FROM call_events WHERE call_id = ANY($1)",
-            call_ids);
+        const bool with_payload = fields == EventFields::kPayload;
+        auto res = trx.Execute(with_payload ? kSelectEventsWithPayload : kSelectEvents, call_ids);
 
         for (const auto& row : res) {
             models::CallEvent ev;
             ev.event_id = row["event_id"].As<std::int64_t>();
             ev.call_id  = row["call_id"].As<std::int64_t>();
-            ev.event_type = row["event_type"].As<std::string>();
-            ev.payload = userver::formats::json::FromString(row["payload"].As<std::string>());
+            ev.event_type = models::Symbol{row["event_type"].As<std::string>()};
+            if (with_payload) ev.payload = row["payload"].As<std::optional<std::string>>().value_or("null");
             result.emplace_back(std::move(ev));
         }
         trx.Commit();
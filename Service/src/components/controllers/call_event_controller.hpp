@@ -3,14 +3,20 @@
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/storages/postgres/cluster.hpp>
 #include <userver/storages/postgres/database.hpp>
+#include <userver/storages/postgres/transaction.hpp>
 #include <userver/logging/log.hpp>
 #include <vector>
 #include <string>
 #include "models/call_event.hpp"
 #include "components/cdr_upload_info.hpp"
+#include "components/cdr_uploaders/finished_calls_channel.hpp"
 
 namespace call_flow_processor::components::controllers {
 
+// Optional columns of CallEventController::GetEvents(); event_id, call_id
+// and event_type are always read.
+enum class EventFields { kNone, kPayload };
+
 class CallEventController final : public userver::components::LoggableComponentBase {
 public:
     static constexpr const char* kName;
@@ -20,13 +26,30 @@ public:
         const userver::components::ComponentContext& context
     );
 
+    // Publishes the finished calls to FinishedCallsChannel after commit.
     void Save(std::vector<models::CallEvent>&& events);
+    // The overloads taking a transaction return the ids of the calls that
+    // finished; the caller publishes them once the transaction is committed.
+    std::vector<std::int64_t> Save(
+        userver::storages::postgres::Transaction& trx, std::vector<models::CallEvent>&& events);
+
+    // Bulk-load path, see CallController::Stage(). Hangups found while
+    // merging are reported to CDRUploadInfo just like in Save().
+    void Stage(std::vector<models::CallEvent>&& events);
+    std::vector<std::int64_t> MergeStaged(userver::storages::postgres::Transaction& trx);
 
-    std::vector<models::CallEvent> GetEvents(const std::vector<std::int64_t>& call_ids);
+    // Without kPayload the payload column is not read at all and
+    // CallEvent::payload stays empty.
+    std::vector<models::CallEvent> GetEvents(
+        const std::vector<std::int64_t>& call_ids, EventFields fields = EventFields::kPayload);
 
 protected:
+    void ExecuteBatch(
+        userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::CallEvent>&& events);
+
     userver::storages::postgres::ClusterPtr pg_;
     components::CDRUploadInfo& cdr_upload_info_;
+    components::FinishedCallsChannel& finished_calls_;
 };
 
 } // namespace call_flow_processor::components::controllers
@@ -1,4 +1,7 @@
 #include "cdr_controller.hpp"
+#include "batch_utils.hpp"
+#include <userver/formats/json/serialize.hpp>
+#include <userver/formats/json/value_builder.hpp>
 
 namespace call_flow_processor::components::controllers {
 
@@ -16,29 +19,7 @@ void CDRController::Save(std::vector<models::CDR>&& cdrs) {
     if (cdrs.empty()) return;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        for (const auto& cdr : cdrs) {
-            trx.Execute(
-                "INSERT INTO cdrs "
-                "(call_id, call_start, call_end, caller_number, callee_number, duration_sec, call_result, call_events) "
-                "VALUES ($1, $2, $3, $4, $5, $6, $7, $8) "
-                "ON CONFLICT (call_id) DO UPDATE SET "
-                "call_start=EXCLUDED.call_start, "
-                "call_end=EXCLUDED.call_end, "
-                "caller_number=EXCLUDED.caller_number, "
-                "callee_number=EXCLUDED.callee_number, "
-                "duration_sec=EXCLUDED.duration_sec, "
-                "call_result=EXCLUDED.call_result, "
-                "call_events=EXCLUDED.call_events;",
-                cdr.call_id,
-                cdr.call_start,
-                cdr.call_end,
-                cdr.caller_number,
-                cdr.callee_number,
-                cdr.duration_sec,
-                cdr.call_result,
-                cdr.call_events
-            );
-        }
+        Save(trx, std::move(cdrs));
         trx.Commit();
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CDRController Save error: " << ex.what();
@@ -46,6 +27,70 @@ void CDRController::Save(std::vector<models::CDR>&& cdrs) {
     }
 }
 
+void CDRController::Save(userver::storages::postgres::Transaction& trx, std::vector<models::CDR>&& cdrs) {
+    if (cdrs.empty()) return;
+    KeepLastByKey(cdrs, [](const models::CDR& cdr) { return cdr.call_id; });
+
+    std::vector<std::string> call_ids;
+    std::vector<userver::storages::postgres::TimePointTz> call_starts;
+    std::vector<userver::storages::postgres::TimePointTz> call_ends;
+    std::vector<std::string> caller_numbers;
+    std::vector<std::string> callee_numbers;
+    std::vector<int> durations;
+    std::vector<std::string> call_results;
+    // Postgres cannot UNNEST an array of arrays row by row, so the per-call
+    // event lists travel as JSON arrays and are expanded back into text[].
+    std::vector<std::string> call_events;
+    call_ids.reserve(cdrs.size());
+    call_starts.reserve(cdrs.size());
+    call_ends.reserve(cdrs.size());
+    caller_numbers.reserve(cdrs.size());
+    callee_numbers.reserve(cdrs.size());
+    durations.reserve(cdrs.size());
+    call_results.reserve(cdrs.size());
+    call_events.reserve(cdrs.size());
+
+    for (const auto& cdr : cdrs) {
+        call_ids.push_back(cdr.call_id);
+        call_starts.push_back(cdr.call_start);
+        call_ends.push_back(cdr.call_end);
+        caller_numbers.push_back(cdr.caller_number);
+        callee_numbers.push_back(cdr.callee_number);
+        durations.push_back(cdr.duration_sec);
+        call_results.push_back(cdr.call_result.Str());
+        userver::formats::json::ValueBuilder events(userver::formats::json::Type::kArray);
+        for (const auto event : cdr.call_events) events.PushBack(event.Str());
+        call_events.push_back(userver::formats::json::ToString(events.ExtractValue()));
+    }
+
+    trx.Execute(
+        "INSERT INTO cdrs "
+        "(call_id, call_start, call_end, caller_number, callee_number, duration_sec, call_result, call_events) "
+        "SELECT u.call_id, u.call_start, u.call_end, u.caller_number, u.callee_number, "
+        "u.duration_sec, u.call_result, "
+        "ARRAY(SELECT json_array_elements_text(u.call_events::json)) "
+        "FROM UNNEST($1::varchar[], $2::timestamptz[], $3::timestamptz[], $4::varchar[], "
+        "$5::varchar[], $6::integer[], $7::varchar[], $8::text[]) "
+        "AS u(call_id, call_start, call_end, caller_number, callee_number, duration_sec, call_result, call_events) "
+        "ON CONFLICT (call_id) DO UPDATE SET "
+        "call_start=EXCLUDED.call_start, "
+        "call_end=EXCLUDED.call_end, "
+        "caller_number=EXCLUDED.caller_number, "
+        "callee_number=EXCLUDED.callee_number, "
+        "duration_sec=EXCLUDED.duration_sec, "
+        "call_result=EXCLUDED.call_result, "
+        "call_events=EXCLUDED.call_events;",
+        call_ids,
+        call_starts,
+        call_ends,
+        caller_numbers,
+        callee_numbers,
+        durations,
+        call_results,
+        call_events
+    );
+}
+
 std::vector<models::CDR> CDRController::GetCDRs(const std::vector<std::string>& call_ids) const {
     std::vector<models::CDR> result;
     if (call_ids.empty()) return result;
@@ -64,8 +109,10 @@ std::vector<models::CDR> CDRController::GetCDRs(const std::vector<std::string>&
             cdr.caller_number = row["caller_number"].As<std::string>();
             cdr.callee_number = row["callee_number"].As<std::string>();
             cdr.duration_sec = row["duration_sec"].As<int>();
-            cdr.call_result = row["call_result"].As<std::string>();
-            cdr.call_events = row["call_events"].As<std::vector<std::string>>();
+            cdr.call_result = models::Symbol{row["call_result"].As<std::string>()};
+            for (const auto& event : row["call_events"].As<std::vector<std::string>>()) {
+                cdr.call_events.emplace_back(event);
+            }
             result.emplace_back(std::move(cdr));
         }
         trx.Commit();
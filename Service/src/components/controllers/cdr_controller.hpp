@@ -2,6 +2,7 @@
 
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/transaction.hpp>
 #include <userver/logging/log.hpp>
 #include <vector>
 #include <string>
@@ -19,6 +20,7 @@ public:
     );
 
     void Save(std::vector<models::CDR>&& cdrs);
+    void Save(userver::storages::postgres::Transaction& trx, std::vector<models::CDR>&& cdrs);
     std::vector<models::CDR> GetCDRs(const std::vector<std::string>& call_ids) const;
 
 protected:
@@ -1,9 +1,50 @@
 #include "connection_controller.hpp"
+#include "batch_utils.hpp"
 #include <userver/logging/log.hpp>
 #include <userver/storages/postgres/database.hpp>
 
 namespace call_flow_processor::components::controllers {
 
+namespace {
+
+constexpr const char* kUpsertConnections =
+    "INSERT INTO connections "
+    "(connection_id, call_id, phone, initiated_at, answered_at, finished_at) "
+    "SELECT * FROM UNNEST("
+    "$1::bigint[], $2::bigint[], $3::varchar[], "
+    "$4::timestamptz[], $5::timestamptz[], $6::timestamptz[]) "
+    "ON CONFLICT(connection_id) DO UPDATE SET "
+    "call_id=EXCLUDED.call_id, phone=EXCLUDED.phone, "
+    "initiated_at=EXCLUDED.initiated_at, "
+    "answered_at=EXCLUDED.answered_at, "
+    "finished_at=EXCLUDED.finished_at;";
+
+constexpr const char* kStageConnections =
+    "INSERT INTO connections_staging "
+    "(connection_id, call_id, phone, initiated_at, answered_at, finished_at) "
+    "SELECT * FROM UNNEST("
+    "$1::bigint[], $2::bigint[], $3::varchar[], "
+    "$4::timestamptz[], $5::timestamptz[], $6::timestamptz[]);";
+
+constexpr const char* kMergeStagedConnections =
+    "INSERT INTO connections "
+    "(connection_id, call_id, phone, initiated_at, answered_at, finished_at) "
+    "SELECT DISTINCT ON (connection_id) "
+    "connection_id, call_id, phone, initiated_at, answered_at, finished_at "
+    "FROM connections_staging ORDER BY connection_id, staged_seq DESC "
+    "ON CONFLICT(connection_id) DO UPDATE SET "
+    "call_id=EXCLUDED.call_id, phone=EXCLUDED.phone, "
+    "initiated_at=EXCLUDED.initiated_at, "
+    "answered_at=EXCLUDED.answered_at, "
+    "finished_at=EXCLUDED.finished_at;";
+
+// The connections of the given calls, first connection of a call first.
+constexpr const char* kSelectConnections =
+    "SELECT connection_id, call_id, phone, initiated_at, answered_at, finished_at "
+    "FROM connections WHERE call_id = ANY($1) ORDER BY call_id, connection_id";
+
+}  // namespace
+
 const char* ConnectionController::kName = "connection-controller";
 
 ConnectionController::ConnectionController(
@@ -18,42 +59,79 @@ void ConnectionController::Save(std::vector<models::Connection>&& connections) {
     if (connections.empty()) return;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+        Save(trx, std::move(connections));
+        trx.Commit();
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "Failed to save connections: " << ex.what();
+        throw;
+    }
+}
 
-        for (const auto& conn : connections) {
-            trx.Execute(
-                "INSERT INTO connections "
-                "(connection_id, call_id, phone, initiated_at, answered_at, finished_at) VALUES "
-                "($1, $2, $3, $4, $5, $6) "
-                "ON CONFLICT(connection_id) DO UPDATE SET "
-                "call_id=EXCLUDED.call_id, phone=EXCLUDED.phone, "
-                "initiated_at=EXCLUDED.initiated_at, "
-                "answered_at=EXCLUDED.answered_at, "
-                "finished_at=EXCLUDED.finished_at;",
-                conn.connection_id,
-                conn.call_id,
-                conn.phone,
-                conn.initiated_at,
-                conn.answered_at,
-                conn.finished_at
-            );
-        }
+void ConnectionController::Save(userver::storages::postgres::Transaction& trx, std::vector<models::Connection>&& connections) {
+    if (connections.empty()) return;
+    KeepLastByKey(connections, [](const models::Connection& conn) { return conn.connection_id; });
+    ExecuteBatch(trx, kUpsertConnections, std::move(connections));
+}
 
+void ConnectionController::Stage(std::vector<models::Connection>&& connections) {
+    if (connections.empty()) return;
+    try {
+        auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+        ExecuteBatch(trx, kStageConnections, std::move(connections));
         trx.Commit();
     } catch (const std::exception& ex) {
-        LOG_ERROR() << "Failed to save connections: " << ex.what();
+        LOG_ERROR() << "Failed to stage connections: " << ex.what();
         throw;
     }
 }
 
-std::vector<models::Connection> ConnectionController::GetConnections(const std::vector<std::int64_t>& connection_ids) {
+void ConnectionController::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    trx.Execute(kMergeStagedConnections);
+    trx.Execute("TRUNCATE connections_staging;");
+}
+
+void ConnectionController::ExecuteBatch(
+    userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::Connection>&& connections) {
+    std::vector<std::int64_t> connection_ids;
+    std::vector<std::int64_t> call_ids;
+    std::vector<std::string> phones;
+    std::vector<userver::storages::postgres::TimePointTz> initiated_at;
+    std::vector<std::optional<userver::storages::postgres::TimePointTz>> answered_at;
+    std::vector<std::optional<userver::storages::postgres::TimePointTz>> finished_at;
+    connection_ids.reserve(connections.size());
+    call_ids.reserve(connections.size());
+    phones.reserve(connections.size());
+    initiated_at.reserve(connections.size());
+    answered_at.reserve(connections.size());
+    finished_at.reserve(connections.size());
+
+    for (auto& conn : connections) {
+        connection_ids.push_back(conn.connection_id);
+        call_ids.push_back(conn.call_id);
+        phones.push_back(std::move(conn.phone));
+        initiated_at.push_back(conn.initiated_at);
+        answered_at.push_back(conn.answered_at);
+        finished_at.push_back(conn.finished_at);
+    }
+
+    trx.Execute(
+        query,
+        connection_ids,
+        call_ids,
+        phones,
+        initiated_at,
+        answered_at,
+        finished_at
+    );
+}
+
+std::vector<models::Connection> ConnectionController::GetConnections(const std::vector<std::int64_t>& call_ids) {
     std::vector<models::Connection> result;
-    if (connection_ids.empty()) return result;
+    if (call_ids.empty()) return result;
 
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        auto res = trx.Execute(
-            "SELECT connection_id, call_id, phone, initiated_at, answered_at, finished_at "
-            "FROM connections WHERE connection_id = ANY($1)", connection_ids);
+        auto res = trx.Execute(kSelectConnections, call_ids);
 
         for (const auto& row : res) {
             models::Connection c;
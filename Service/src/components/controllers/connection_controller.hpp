@@ -2,6 +2,7 @@
 
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/transaction.hpp>
 #include <optional>
 #include <vector>
 #include <string>
@@ -19,9 +20,19 @@ public:
     );
 
     void Save(std::vector<models::Connection>&& connections);
-    std::vector<models::Connection> GetConnections(const std::vector<std::int64_t>& connection_ids);
+    void Save(userver::storages::postgres::Transaction& trx, std::vector<models::Connection>&& connections);
+
+    // Bulk-load path, see CallController::Stage().
+    void Stage(std::vector<models::Connection>&& connections);
+    void MergeStaged(userver::storages::postgres::Transaction& trx);
+
+    // The connections of the calls call_ids.
+    std::vector<models::Connection> GetConnections(const std::vector<std::int64_t>& call_ids);
 
 protected:
+    void ExecuteBatch(
+        userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::Connection>&& connections);
+
     userver::storages::postgres::ClusterPtr pg_;
 };
 
@@ -1,78 +1,101 @@
 #include "operator_controller.hpp"
+#include "batch_utils.hpp"
 #include <userver/logging/log.hpp>
 
 namespace call_flow_processor::components::controllers {
 
+namespace {
+
+constexpr const char* kUpsertOperators =
+    "INSERT INTO operators (operator_id, name, extension, email) "
+    "SELECT * FROM UNNEST($1::bigint[], $2::varchar[], $3::varchar[], $4::varchar[]) "
+    "ON CONFLICT(operator_id) DO UPDATE "
+    "SET name=EXCLUDED.name, extension=EXCLUDED.extension, email=EXCLUDED.email, updated_at=now();";
+
+constexpr const char* kStageOperators =
+    "INSERT INTO operators_staging (operator_id, name, extension, email) "
+    "SELECT * FROM UNNEST($1::bigint[], $2::varchar[], $3::varchar[], $4::varchar[]);";
+
+constexpr const char* kMergeStagedOperators =
+    "INSERT INTO operators (operator_id, name, extension, email) "
+    "SELECT DISTINCT ON (operator_id) operator_id, name, extension, email "
+    "FROM operators_staging ORDER BY operator_id, staged_seq DESC "
+    "ON CONFLICT(operator_id) DO UPDATE "
+    "SET name=EXCLUDED.name, extension=EXCLUDED.extension, email=EXCLUDED.email, updated_at=now();";
+
+}  // namespace
+
 const char* OperatorController::kName = "operator-controller";
 
 OperatorController::OperatorController(
     const userver::components::ComponentConfig& config,
     const userver::components::ComponentContext& context)
 : userver::components::LoggableComponentBase(config, context),
-  pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()}
+  pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()},
+  operator_cache_{context.FindComponent<caches::OperatorCache>()}
 {}
 
 void OperatorController::Save(std::vector<models::Operator>&& operators) {
     if (operators.empty()) return;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        for (const auto& op : operators) {
-            trx.Execute(
-                "INSERT INTO operators (operator_id, name, extension, email) "
-                "VALUES ($1, $2, $3, $4) "
-                "ON CONFLICT(operator_id) DO UPDATE "
-                "SET name=EXCLUDED.name, extension=EXCLUDED.extension, email=EXCLUDED.email;",
-                op.operator_id,
-                op.name,
-                op.extension,
-                op.email
-            );
-        }
+        Save(trx, std::move(operators));
         trx.Commit();
+        operator_cache_.InvalidateAsync(userver::cache::UpdateType::kIncremental);
     } catch (const std::exception& ex) {
         LOG_ERROR() << "OperatorController Save error: " << ex.what();
         throw;
     }
 }
 
-std::vector<models::Operator> OperatorController::GetOperators(const std::vector<std::int64_t>& operator_ids) {
-    std::vector<models::Operator> result;
-    if (operator_ids.empty()) return result;
+void OperatorController::Save(userver::storages::postgres::Transaction& trx, std::vector<models::Operator>&& operators) {
+    if (operators.empty()) return;
+    KeepLastByKey(operators, [](const models::Operator& op) { return op.operator_id; });
+    ExecuteBatch(trx, kUpsertOperators, std::move(operators));
+}
+
+void OperatorController::Stage(std::vector<models::Operator>&& operators) {
+    if (operators.empty()) return;
     try {
         auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
-        auto res = trx.Execute(
-            "SELECT operator_id, name, extension, email FROM operators WHERE operator_id = ANY($1)",
-            operator_ids);
-
-        for (const auto& row : res) {
-            models::Operator op;
-            op.operator_id = row["operator_id"].As<std::int64_t>();
-            op.name = row["name"].As<std::string>();
-            op.extension = row["extension"].As<std::string>();
-            op.email = row["email"].As<std::string>();
-            result.emplace_back(std::move(op));
-        }
+        ExecuteBatch(trx, kStageOperators, std::move(operators));
         trx.Commit();
     } catch (const std::exception& ex) {
-        LOG_ERROR() << "OperatorController GetOperators error: " << ex.what();
+        LOG_ERROR() << "OperatorController Stage error: " << ex.what();
         throw;
     }
-    return result;
 }
 
-std::vector<models::Operator> OperatorController::GetAllOperators() {
-    std::vector<models::Operator> res;
-    auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kSlave);
-    auto r = trx.Execute("SELECT operator_id, name, extension, email FROM operators");
-    for (const auto& row : r) {
-        models::Operator op;
-        op.operator_id = row["operator_id"].As<std::int64_t>();
-        op.name = row["name"].As<std::string>();
-        op.extension = row["extension"].As<std::string>();
-        op.email = row["email"].As<std::string>();
-        res.emplace_back(std::move(op));
+void OperatorController::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    trx.Execute(kMergeStagedOperators);
+    trx.Execute("TRUNCATE operators_staging;");
+}
+
+void OperatorController::ExecuteBatch(
+    userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::Operator>&& operators) {
+    std::vector<std::int64_t> operator_ids;
+    std::vector<std::string> names;
+    std::vector<std::string> extensions;
+    std::vector<std::string> emails;
+    operator_ids.reserve(operators.size());
+    names.reserve(operators.size());
+    extensions.reserve(operators.size());
+    emails.reserve(operators.size());
+
+    for (auto& op : operators) {
+        operator_ids.push_back(op.operator_id);
+        names.push_back(std::move(op.name));
+        extensions.push_back(std::move(op.extension));
+        emails.push_back(std::move(op.email));
     }
-    return res;
+
+    trx.Execute(
+        query,
+        operator_ids,
+        names,
+        extensions,
+        emails
+    );
 }
 
 }  // namespace call_flow_processor::components::controllers
@@ -2,8 +2,10 @@
 
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/storages/postgres/cluster.hpp>
+#include <userver/storages/postgres/transaction.hpp>
 #include <vector>
 #include <string>
+#include "components/caches/operator_cache.hpp"
 #include "models/operator.hpp"
 
 namespace call_flow_processor::components::controllers {
@@ -16,12 +18,21 @@ public:
         const userver::components::ComponentConfig& config,
         const userver::components::ComponentContext& context);
 
+    // Reads go through caches::OperatorCache. Save() refreshes it after the
+    // commit; callers of the transactional overload do it themselves.
     void Save(std::vector<models::Operator>&& operators);
-    std::vector<models::Operator> GetOperators(const std::vector<std::int64_t>& operator_ids);
-    std::vector<models::Operator> GetAllOperators();
+    void Save(userver::storages::postgres::Transaction& trx, std::vector<models::Operator>&& operators);
+
+    // Bulk-load path, see CallController::Stage().
+    void Stage(std::vector<models::Operator>&& operators);
+    void MergeStaged(userver::storages::postgres::Transaction& trx);
 
 protected:
+    void ExecuteBatch(
+        userver::storages::postgres::Transaction& trx, const char* query, std::vector<models::Operator>&& operators);
+
     userver::storages::postgres::ClusterPtr pg_;
+    caches::OperatorCache& operator_cache_;
 };
 
 }  // namespace call_flow_processor::components::controllers
@@ -1,7 +1,6 @@
 #include "call_data_fetcher.hpp"
+#include "parsers/binary_batch.hpp"
 #include <userver/clients/http/component.hpp>
-#include <userver/formats/json/parse.hpp>
-#include <userver/formats/json/value.hpp>
 #include <userver/logging/log.hpp>
 
 namespace call_flow_processor::components::data_fetchers {
@@ -21,13 +20,15 @@ std::string CallDataFetcher::GetId() {
     return "call-data-fetcher";
 }
 
-std::vector<models::Call> CallDataFetcher::Fetch(std::int64_t cursor) {
-    std::vector<models::Call> result;
+FetchResult<models::Call> CallDataFetcher::Fetch(std::int64_t cursor, int partition) {
+    FetchResult<models::Call> result;
     try {
-        const auto url = endpoint_ + "?cursor=" + std::to_string(cursor) + "&limit=" + std::to_string(fetch_limit_);
+        const auto url = endpoint_ + "?cursor=" + std::to_string(cursor) + "&limit=" + std::to_string(fetch_limit_)
+            + PartitionQuery(partition);
 
         auto response = http_client_.CreateRequest()
             .get(url)
+            .header("Accept", std::string{parsers::kBatchAccept})
             .timeout(std::chrono::seconds(10))
             .perform();
 
@@ -36,37 +37,31 @@ std::vector<models::Call> CallDataFetcher::Fetch(std::int64_t cursor) {
             return result;
         }
 
-        const auto json = userver::formats::json::FromString(response->body);
-
-        if (!json.IsArray()) {
-            LOG_ERROR() << "Fetch: json response is not array";
-            return result;
-        }
-
-        for (const auto& item : json) {
-            try {
-                models::Call call;
-                call.id = item["id"].As<std::int64_t>();
-                call.status = item["status"].As<std::string>();
-                call.started_at = item["started_at"].As<userver::storages::postgres::TimePointTz>();
-                call.user_id = item["user_id"].As<std::int64_t>();
-                result.push_back(std::move(call));
-            } catch (const std::exception& ex){
-                LOG_ERROR() << "Failed to parse call: " << ex.what();
-            }
-        }
+        std::vector<models::Call> items;
+        items.reserve(fetch_limit_);
+        const auto page = parsers::DecodePage(ResponseContentType(*response), response->body, items);
+        result.items = std::move(items);
+        result.has_more = page.has_next_cursor
+            || page.item_count >= static_cast<std::size_t>(fetch_limit_);
     } catch (const std::exception& ex) {
         LOG_ERROR() << "Fetch failed: " << ex.what();
     }
     return result;
 }
 
-void CallDataFetcher::Store(std::vector<models::Call>&& data) {
-    try {
-        call_controller_.Save(std::move(data));
-    } catch (const std::exception& ex) {
-        LOG_ERROR() << "Store failed: " << ex.what();
-    }
+std::vector<std::int64_t> CallDataFetcher::Store(
+    userver::storages::postgres::Transaction& trx, std::vector<models::Call>&& data) {
+    call_controller_.Save(trx, std::move(data));
+    return {};
+}
+
+void CallDataFetcher::Stage(std::vector<models::Call>&& data) {
+    call_controller_.Stage(std::move(data));
+}
+
+std::vector<std::int64_t> CallDataFetcher::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    call_controller_.MergeStaged(trx);
+    return {};
 }
 
 }  // namespace call_flow_processor::components::data_fetchers
@@ -18,8 +18,11 @@ public:
 
 protected:
     std::string GetId() override;
-    std::vector<models::Call> Fetch(std::int64_t cursor) override;
-    void Store(std::vector<models::Call>&& data) override;
+    FetchResult<models::Call> Fetch(std::int64_t cursor, int partition) override;
+    std::vector<std::int64_t> Store(
+        userver::storages::postgres::Transaction& trx, std::vector<models::Call>&& data) override;
+    void Stage(std::vector<models::Call>&& data) override;
+    std::vector<std::int64_t> MergeStaged(userver::storages::postgres::Transaction& trx) override;
 
     userver::clients::http::Client& http_client_;
     controllers::CallController& call_controller_;
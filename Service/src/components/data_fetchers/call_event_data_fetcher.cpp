@@ -1,7 +1,6 @@
 #include "call_event_data_fetcher.hpp"
+#include "parsers/binary_batch.hpp"
 #include <userver/clients/http/component.hpp>
-#include <userver/formats/json/parse.hpp>
-#include <userver/formats/json/value.hpp>
 #include <userver/logging/log.hpp>
 
 namespace call_flow_processor::components::data_fetchers {
@@ -21,14 +20,15 @@ std::string CallEventDataFetcher::GetId() {
     return "call-event-data-fetcher";
 }
 
-std::vector<models::CallEvent> CallEventDataFetcher::Fetch(std::int64_t cursor) {
-    std::vector<models::CallEvent> result;
+FetchResult<models::CallEvent> CallEventDataFetcher::Fetch(std::int64_t cursor, int partition) {
+    FetchResult<models::CallEvent> result;
     try {
         const auto url = endpoint_ + "?cursor=" + std::to_string(cursor)
-            + "&limit=" + std::to_string(fetch_limit_);
+            + "&limit=" + std::to_string(fetch_limit_) + PartitionQuery(partition);
 
         auto response = http_client_.CreateRequest()
             .get(url)
+            .header("Accept", std::string{parsers::kBatchAccept})
             .timeout(std::chrono::seconds(10))
             .perform();
 
@@ -38,37 +38,29 @@ std::vector<models::CallEvent> CallEventDataFetcher::Fetch(std::int64_t cursor)
             return result;
         }
 
-        const auto json = userver::formats::json::FromString(response->body);
-
-        if (!json.IsArray()) {
-            LOG_ERROR() << "CallEventDataFetcher fetch: response is not array";
-            return result;
-        }
-
-        for (const auto& item : json) {
-            try {
-                models::CallEvent ev;
-                ev.event_id = item["event_id"].As<std::int64_t>();
-                ev.call_id  = item["call_id"].As<std::int64_t>();
-                ev.event_type = item["event_type"].As<std::string>();
-                ev.payload = item["payload"];
-                result.emplace_back(std::move(ev));
-            } catch (const std::exception& ex) {
-                LOG_ERROR() << "CallEventDataFetcher failed to parse row: " << ex.what();
-            }
-        }
+        std::vector<models::CallEvent> items;
+        items.reserve(fetch_limit_);
+        const auto page = parsers::DecodePage(ResponseContentType(*response), response->body, items);
+        result.items = std::move(items);
+        result.has_more = page.has_next_cursor
+            || page.item_count >= static_cast<std::size_t>(fetch_limit_);
     } catch (const std::exception& ex) {
         LOG_ERROR() << "CallEventDataFetcher fetch failed: " << ex.what();
     }
     return result;
 }
 
-void CallEventDataFetcher::Store(std::vector<models::CallEvent>&& data) {
-    try {
-        call_event_controller_.Save(std::move(data));
-    } catch (const std::exception& ex) {
-        LOG_ERROR() << "CallEventDataFetcher store failed: " << ex.what();
-    }
+std::vector<std::int64_t> CallEventDataFetcher::Store(
+    userver::storages::postgres::Transaction& trx, std::vector<models::CallEvent>&& data) {
+    return call_event_controller_.Save(trx, std::move(data));
+}
+
+void CallEventDataFetcher::Stage(std::vector<models::CallEvent>&& data) {
+    call_event_controller_.Stage(std::move(data));
+}
+
+std::vector<std::int64_t> CallEventDataFetcher::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    return call_event_controller_.MergeStaged(trx);
 }
 
 } // namespace call_flow_processor::components::data_fetchers
@@ -1,9 +1,7 @@
 #include "connection_data_fetcher.hpp"
+#include "parsers/binary_batch.hpp"
 #include <userver/clients/http/component.hpp>
-#include <userver/formats/json/parse.hpp>
-#include <userver/formats/json/value.hpp>
 #include <userver/logging/log.hpp>
-#include <optional>
 
 namespace call_flow_processor::components::data_fetchers {
 
@@ -22,14 +20,15 @@ std::string ConnectionDataFetcher::GetId() {
     return "connection-data-fetcher";
 }
 
-std::vector<models::Connection> ConnectionDataFetcher::Fetch(std::int64_t cursor) {
-    std::vector<models::Connection> result;
+FetchResult<models::Connection> ConnectionDataFetcher::Fetch(std::int64_t cursor, int partition) {
+    FetchResult<models::Connection> result;
     try {
         const auto url = endpoint_ + "?cursor=" + std::to_string(cursor)
-            + "&limit=" + std::to_string(fetch_limit_);
+            + "&limit=" + std::to_string(fetch_limit_) + PartitionQuery(partition);
 
         auto response = http_client_.CreateRequest()
             .get(url)
+            .header("Accept", std::string{parsers::kBatchAccept})
             .timeout(std::chrono::seconds(10))
             .perform();
 
@@ -39,41 +38,31 @@ std::vector<models::Connection> ConnectionDataFetcher::Fetch(std::int64_t cursor
             return result;
         }
 
-        const auto json = userver::formats::json::FromString(response->body);
-
-        if (!json.IsArray()) {
-            LOG_ERROR() << "ConnectionDataFetcher fetch: response is not array";
-            return result;
-        }
-
-        for (const auto& item : json) {
-            try {
-                models::Connection conn;
-                conn.connection_id = item["connection_id"].As<std::int64_t>();
-                conn.call_id       = item["call_id"].As<std::int64_t>();
-                conn.phone         = item["phone"].As<std::string>();
-                conn.initiated_at  = item["initiated_at"].As<userver::storages::postgres::TimePointTz>();
-                conn.answered_at   = item["answered_at"].IsMissing() ? std::nullopt :
-                    std::make_optional(item["answered_at"].As<userver::storages::postgres::TimePointTz>());
-                conn.finished_at   = item["finished_at"].IsMissing() ? std::nullopt :
-                    std::make_optional(item["finished_at"].As<userver::storages::postgres::TimePointTz>());
-                result.emplace_back(std::move(conn));
-            } catch (const std::exception& ex) {
-                LOG_ERROR() << "Failed to parse connection row: " << ex.what();
-            }
-        }
+        std::vector<models::Connection> items;
+        items.reserve(fetch_limit_);
+        const auto page = parsers::DecodePage(ResponseContentType(*response), response->body, items);
+        result.items = std::move(items);
+        result.has_more = page.has_next_cursor
+            || page.item_count >= static_cast<std::size_t>(fetch_limit_);
     } catch (const std::exception& ex) {
         LOG_ERROR() << "ConnectionDataFetcher fetch failed: " << ex.what();
     }
     return result;
 }
 
-void ConnectionDataFetcher::Store(std::vector<models::Connection>&& data) {
-    try {
-        connection_controller_.Save(std::move(data));
-    } catch (const std::exception& ex) {
-        LOG_ERROR() << "ConnectionDataFetcher store failed: " << ex.what();
-    }
+std::vector<std::int64_t> ConnectionDataFetcher::Store(
+    userver::storages::postgres::Transaction& trx, std::vector<models::Connection>&& data) {
+    connection_controller_.Save(trx, std::move(data));
+    return {};
+}
+
+void ConnectionDataFetcher::Stage(std::vector<models::Connection>&& data) {
+    connection_controller_.Stage(std::move(data));
+}
+
+std::vector<std::int64_t> ConnectionDataFetcher::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    connection_controller_.MergeStaged(trx);
+    return {};
 }
 
 } // namespace call_flow_processor::components::data_fetchers
@@ -18,8 +18,11 @@ public:
 
 protected:
     std::string GetId() override;
-    std::vector<models::Connection> Fetch(std::int64_t cursor) override;
-    void Store(std::vector<models::Connection>&& data) override;
+    FetchResult<models::Connection> Fetch(std::int64_t cursor, int partition) override;
+    std::vector<std::int64_t> Store(
+        userver::storages::postgres::Transaction& trx, std::vector<models::Connection>&& data) override;
+    void Stage(std::vector<models::Connection>&& data) override;
+    std::vector<std::int64_t> MergeStaged(userver::storages::postgres::Transaction& trx) override;
 
     userver::clients::http::Client& http_client_;
     controllers::ConnectionController& connection_controller_;
@@ -1,73 +1,303 @@
 #pragma once
 
 #include <userver/storages/postgres/dist_lock_component_base.hpp>
+#include <userver/clients/http/response.hpp>
+#include <userver/storages/postgres/dist_lock_strategy.hpp>
+#include <userver/dist_lock/dist_locked_worker.hpp>
 #include <userver/components/component_base.hpp>
 #include <userver/components/component_config.hpp>
 #include <userver/components/component_context.hpp>
+#include <userver/concurrent/queue.hpp>
+#include <userver/engine/sleep.hpp>
 #include <userver/engine/task/cancel.hpp>
 #include <userver/storages/postgres/component.hpp>
 #include <userver/storages/postgres/cluster.hpp>
 #include <userver/storages/postgres/database.hpp>
+#include <userver/storages/postgres/transaction.hpp>
 #include <userver/logging/log.hpp>
+#include <userver/utils/async.hpp>
 #include <userver/utils/datetime.hpp>
+#include <userver/utils/rand.hpp>
+#include <userver/utils/statistics/storage.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <userver/components/statistics_storage.hpp>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
+#include "components/cdr_uploaders/finished_calls_channel.hpp"
 
 namespace call_flow_processor::components::data_fetchers {
 
+// How fetched pages reach the main tables:
+//  * kUpsert  - every page is upserted right away (default);
+//  * kStaging - pages are appended to an unlogged staging table and merged
+//               with one set-based upsert; meant for backfills.
+enum class WriteMode { kUpsert, kStaging };
+
+inline WriteMode ParseWriteMode(const std::string& value) {
+    if (value == "upsert") return WriteMode::kUpsert;
+    if (value == "staging") return WriteMode::kStaging;
+    throw std::runtime_error("Unknown data fetcher write-mode: " + value);
+}
+
+// Settings of the partition workers' locks, built from the same config keys
+// and in the same way as DistLockComponentBase builds the component's own
+// lock, so every partition of a stream is held and prolonged alike.
+inline userver::dist_lock::DistLockSettings PartitionLockSettings(const userver::components::ComponentConfig& config) {
+    constexpr int kProlongRatio = 10;
+    const auto ttl = config["lock-ttl"].As<std::chrono::milliseconds>();
+    const auto pg_timeout = config["pg-timeout"].As<std::chrono::milliseconds>();
+    if (pg_timeout >= ttl / kProlongRatio) {
+        throw std::runtime_error(
+            "Data fetcher " + config.Name() + ": pg-timeout must be less than lock-ttl / " + std::to_string(kProlongRatio));
+    }
+    userver::dist_lock::DistLockSettings settings{ttl / kProlongRatio, ttl / kProlongRatio, ttl, pg_timeout};
+    settings.worker_func_restart_delay =
+        config["restart-delay"].As<std::chrono::milliseconds>(settings.worker_func_restart_delay);
+    return settings;
+}
+
+// One page of a source partition. has_more is set when the source reported a
+// non-null next_cursor or returned a full page, i.e. it is not caught up yet.
+template <class T>
+struct FetchResult {
+    std::vector<T> items;
+    bool has_more{false};
+};
+
 template <class T>
 class DataFetcherBase : public userver::storages::postgres::DistLockComponentBase {
 public:
     DataFetcherBase(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context)
         : userver::storages::postgres::DistLockComponentBase(config, context),
-          pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()} {}
+          pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()},
+          finished_calls_{context.FindComponent<FinishedCallsChannel>("finished-calls-channel")},
+          write_mode_{ParseWriteMode(config["write-mode"].As<std::string>("upsert"))},
+          staging_merge_pages_{config["staging-merge-pages"].As<int>(20)},
+          max_in_flight_pages_{config["max-in-flight-pages"].As<std::size_t>(2)},
+          idle_backoff_initial_{config["idle-backoff-initial-ms"].As<std::int64_t>(250)},
+          idle_backoff_max_{config["idle-backoff-max-ms"].As<std::int64_t>(3000)},
+          partitions_count_{config["partitions"].As<int>(1)} {
+        if (partitions_count_ < 1) {
+            throw std::runtime_error("Data fetcher " + config.Name() + ": partitions must be positive");
+        }
+        // The staging tables are shared and truncated by every merge, which
+        // would drop rows another partition has staged but not merged yet.
+        if (partitions_count_ > 1 && write_mode_ == WriteMode::kStaging) {
+            throw std::runtime_error("Data fetcher " + config.Name() + ": write-mode staging requires partitions: 1");
+        }
+
+        for (int index = 0; index < partitions_count_; ++index) {
+            partitions_.push_back(std::make_unique<Partition>(index));
+        }
+
+        // Partition 0 runs in DoWork() under the component's own lock, every
+        // other partition gets a worker with a lock of its own, so partitions
+        // of one stream are spread over the service instances.
+        const auto lock_name = config["lock-name"].As<std::string>(config.Name());
+        const auto lock_table = config["table"].As<std::string>("call_flow_processor.distlocks");
+        const auto lock_settings = PartitionLockSettings(config);
+        for (int index = 1; index < partitions_count_; ++index) {
+            const auto partition_lock_name = lock_name + "-" + std::to_string(index);
+            partition_workers_.push_back(std::make_unique<userver::dist_lock::DistLockedWorker>(
+                partition_lock_name,
+                [this, index] { RunPartition(*partitions_[index]); },
+                std::make_shared<userver::storages::postgres::DistLockStrategy>(
+                    pg_, lock_table, partition_lock_name, lock_settings),
+                lock_settings));
+        }
+
+        statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>()
+            .GetStorage()
+            .RegisterWriter(
+                "data-fetcher",
+                [this](userver::utils::statistics::Writer& writer) {
+                    for (const auto& partition : partitions_) {
+                        const auto label = std::to_string(partition->index);
+                        writer["draining"].ValueWithLabels(
+                            partition->draining.load() ? 1 : 0, {"partition", label});
+                        writer["idle-backoff-ms"].ValueWithLabels(
+                            partition->current_backoff_ms.load(), {"partition", label});
+                    }
+                },
+                {{"fetcher", config.Name()}});
+    }
+
+    ~DataFetcherBase() override { statistics_holder_.Unregister(); }
+
+    // Partition workers call into the derived fetcher, so they are started
+    // only once every component is constructed.
+    void OnAllComponentsLoaded() override {
+        userver::storages::postgres::DistLockComponentBase::OnAllComponentsLoaded();
+        for (auto& worker : partition_workers_) worker->Start();
+    }
+
+    void OnAllComponentsAreStopping() override {
+        for (auto& worker : partition_workers_) worker->Stop();
+        userver::storages::postgres::DistLockComponentBase::OnAllComponentsAreStopping();
+    }
 
 protected:
     virtual std::string GetId() = 0;
-    virtual std::vector<T> Fetch(std::int64_t cursor) = 0;
-    virtual void Store(std::vector<T>&& data) = 0;
+    virtual FetchResult<T> Fetch(std::int64_t cursor, int partition) = 0;
+    // Store() and MergeStaged() return the ids of calls that finished with
+    // the written rows; they are published to the uploaders after commit.
+    virtual std::vector<std::int64_t> Store(userver::storages::postgres::Transaction& trx, std::vector<T>&& data) = 0;
+    virtual void Stage(std::vector<T>&& data) = 0;
+    virtual std::vector<std::int64_t> MergeStaged(userver::storages::postgres::Transaction& trx) = 0;
+    // Called after Store() or MergeStaged() rows are committed.
+    virtual void OnCommitted() {}
+
+    // Query string suffix selecting the partition at the source. The source
+    // assigns every row to hash(id) % partitions; nothing is sent when the
+    // stream is not partitioned.
+    std::string PartitionQuery(int partition) const {
+        if (partitions_count_ == 1) return {};
+        return "&partition=" + std::to_string(partition) + "&partitions=" + std::to_string(partitions_count_);
+    }
+
+    // Sources are asked for pages with parsers::kBatchAccept and may answer
+    // with either JSON or a binary batch; the page is decoded by this value.
+    static std::string ResponseContentType(const userver::clients::http::Response& response) {
+        const auto& headers = response.headers();
+        const auto it = headers.find("Content-Type");
+        return it == headers.end() ? std::string{} : it->second;
+    }
 
-    std::int64_t GetCursor() {
+    // Every partition keeps its own cursor row. The row name includes the
+    // partition count, so changing it starts a fresh set of cursors.
+    std::string GetCursorId(int partition) {
+        if (partitions_count_ == 1) return GetId();
+        return GetId() + "#" + std::to_string(partition) + "/" + std::to_string(partitions_count_);
+    }
+
+    // The cursor is read from the primary once per DoWork() and then kept in
+    // memory: a lagging replica could otherwise move the fetcher backwards.
+    // A partition without a cursor of its own starts from the unpartitioned
+    // one: every row up to it has been stored, whatever partition it is in.
+    std::int64_t LoadCursor(int partition) {
         try {
             auto res = pg_->Execute(
-              userver::storages::postgres::ClusterHostType::kSlave,
-              "SELECT cursor FROM call_flow_processor.data_fetchers WHERE id=$1;", GetId());
+              userver::storages::postgres::ClusterHostType::kMaster,
+              "SELECT cursor FROM call_flow_processor.data_fetchers WHERE fetcher_id IN ($1, $2) "
+              "ORDER BY fetcher_id=$1 DESC LIMIT 1;",
+              GetCursorId(partition), GetId());
 
             if (res.IsEmpty())
                 return 0; // default cursor if not set
 
             return res.AsSingleRow<std::int64_t>();
         } catch (const std::exception& e) {
-            LOG_ERROR() << "Failed to get cursor: " << e.what();
-            return 0;
+            LOG_ERROR() << "Failed to load cursor: " << e.what();
+            throw;
         }
     }
 
-    void UpdateCursor(std::int64_t cursor) {
-        try {
-            pg_->Execute(
-              userver::storages::postgres::ClusterHostType::kMaster,
-              "INSERT INTO call_flow_processor.data_fetchers(id, cursor) VALUES($1, $2) "
-              "ON CONFLICT(id) DO UPDATE SET cursor=EXCLUDED.cursor;",
-              GetId(), cursor);
-        } catch (const std::exception& e) {
-            LOG_ERROR() << "Failed to update cursor: " << e.what();
+    // Written in the same transaction as the rows it covers, so the cursor
+    // advances exactly once per committed page.
+    void UpdateCursor(userver::storages::postgres::Transaction& trx, int partition, std::int64_t cursor) {
+        trx.Execute(
+          "INSERT INTO call_flow_processor.data_fetchers(fetcher_id, cursor) VALUES($1, $2) "
+          "ON CONFLICT(fetcher_id) DO UPDATE SET cursor=EXCLUDED.cursor;",
+          GetCursorId(partition), cursor);
+    }
+
+    // Ingestion state of one partition. It is only touched by the coroutines
+    // of that partition, except for the atomics read by the metrics writer.
+    struct Partition {
+        explicit Partition(int index) : index{index} {}
+
+        const int index;
+        // Cursor of the last committed page.
+        std::int64_t cursor{0};
+        std::optional<std::int64_t> staged_cursor;
+        int staged_pages{0};
+
+        std::atomic<bool> draining{false};
+        std::atomic<std::int64_t> current_backoff_ms{0};
+    };
+
+    // Fetching and storing run in separate coroutines connected by a bounded
+    // queue: page N+1 is being downloaded while page N is written. Pages are
+    // stored and the cursor advanced strictly in fetch order, so a restart
+    // resumes from the last stored page.
+    void DoWork() override { RunPartition(*partitions_[0]); }
+
+    void RunPartition(Partition& partition) {
+        LOG_INFO() << "Starting DataFetcher: " << GetCursorId(partition.index);
+        partition.cursor = LoadCursor(partition.index);
+        while (!userver::engine::current_task::IsCancelRequested()) {
+            if (!RunPipeline(partition)) {
+                userver::engine::InterruptibleSleepFor(std::chrono::seconds(3));
+            }
+        }
+    }
+
+    struct Page {
+        std::int64_t next_cursor{0};
+        std::vector<T> data;
+        bool caught_up{false};
+    };
+    using PageQueue = userver::concurrent::SpscQueue<Page>;
+
+    // Returns false if the pipeline has to be restarted from the committed
+    // cursor because a page could not be written.
+    bool RunPipeline(Partition& partition) {
+        partition.staged_cursor.reset();
+        partition.staged_pages = 0;
+
+        auto queue = PageQueue::Create(max_in_flight_pages_);
+        auto fetch_task = userver::utils::Async(
+            "data-fetcher-prefetch",
+            [this, &partition, producer = queue->GetProducer()]() mutable {
+                PrefetchPages(partition, producer);
+            });
+
+        auto consumer = queue->GetConsumer();
+        Page page;
+        while (!userver::engine::current_task::IsCancelRequested() && consumer.Pop(page)) {
+            if (write_mode_ == WriteMode::kStaging) {
+                if (!StagePage(partition, page.next_cursor, std::move(page.data), page.caught_up)) return false;
+            } else if (!page.data.empty()) {
+                if (!StorePage(partition, page.next_cursor, std::move(page.data))) return false;
+            }
         }
+        return true;
     }
 
-    void DoWork() override {
-        LOG_INFO() << "Starting DataFetcher: " << GetId();
+    // Pages are requested back to back while the source reports more data.
+    // Once it is caught up the fetcher backs off exponentially with jitter,
+    // from idle_backoff_initial_ up to idle_backoff_max_.
+    void PrefetchPages(Partition& partition, typename PageQueue::Producer& producer) {
+        auto cursor = partition.cursor;
+        auto backoff = idle_backoff_initial_;
         while (!userver::engine::current_task::IsCancelRequested()) {
-            auto cursor = GetCursor();
-            auto data = Fetch(cursor);
+            auto page = Fetch(cursor, partition.index);
+            const bool caught_up = !page.has_more || page.items.empty();
+            if (!page.items.empty()) {
+                cursor = GetNextCursor(cursor, page.items);
+                backoff = idle_backoff_initial_;
+            }
 
-            if (!data.empty()) {
-                Store(std::move(data));
-                UpdateCursor(GetNextCursor(cursor, data));
+            // Empty pages are forwarded too: staging mode merges on them.
+            if (!producer.Push(Page{cursor, std::move(page.items), caught_up})) return;
+
+            partition.draining = !caught_up;
+            if (!caught_up) {
+                partition.current_backoff_ms = 0;
+                continue;
             }
 
-            // Backoff to avoid spinning
-            userver::engine::InterruptibleSleepFor(std::chrono::seconds(3));
+            partition.current_backoff_ms = backoff.count();
+            userver::engine::InterruptibleSleepFor(std::chrono::milliseconds{
+                userver::utils::RandRange(backoff.count() / 2, backoff.count() + 1)});
+            backoff = std::min(backoff * 2, idle_backoff_max_);
         }
     }
 
@@ -80,7 +310,63 @@ protected:
         return max_cursor;
     }
 
+    bool StorePage(Partition& partition, std::int64_t next_cursor, std::vector<T>&& data) {
+        try {
+            auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+            const auto finished_call_ids = Store(trx, std::move(data));
+            UpdateCursor(trx, partition.index, next_cursor);
+            trx.Commit();
+            partition.cursor = next_cursor;
+            finished_calls_.Publish(finished_call_ids);
+            OnCommitted();
+            return true;
+        } catch (const std::exception& e) {
+            LOG_ERROR() << "DataFetcher " << GetCursorId(partition.index) << " store failed: " << e.what();
+            return false;
+        }
+    }
+
+    // Staged pages are merged every staging_merge_pages_ pages or as soon as
+    // the source is caught up. The cursor is committed only with a merge, so
+    // a restart re-fetches pages that were staged but not merged yet; the
+    // merge keeps the newest copy of every row.
+    bool StagePage(Partition& partition, std::int64_t next_cursor, std::vector<T>&& data, bool caught_up) {
+        try {
+            if (!data.empty()) {
+                Stage(std::move(data));
+                partition.staged_cursor = next_cursor;
+                ++partition.staged_pages;
+            }
+            if (partition.staged_pages > 0 && (caught_up || partition.staged_pages >= staging_merge_pages_)) {
+                auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+                const auto finished_call_ids = MergeStaged(trx);
+                UpdateCursor(trx, partition.index, *partition.staged_cursor);
+                trx.Commit();
+                partition.cursor = *partition.staged_cursor;
+                partition.staged_cursor.reset();
+                partition.staged_pages = 0;
+                finished_calls_.Publish(finished_call_ids);
+                OnCommitted();
+            }
+            return true;
+        } catch (const std::exception& e) {
+            LOG_ERROR() << "DataFetcher " << GetCursorId(partition.index) << " staging failed: " << e.what();
+            return false;
+        }
+    }
+
     userver::storages::postgres::ClusterPtr pg_;
+    FinishedCallsChannel& finished_calls_;
+    const WriteMode write_mode_;
+    const int staging_merge_pages_;
+    const std::size_t max_in_flight_pages_;
+    const std::chrono::milliseconds idle_backoff_initial_;
+    const std::chrono::milliseconds idle_backoff_max_;
+    const int partitions_count_;
+
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    std::vector<std::unique_ptr<userver::dist_lock::DistLockedWorker>> partition_workers_;
+    userver::utils::statistics::Entry statistics_holder_;
 };
 
 }  // namespace call_flow_processor::components::data_fetchers
@@ -1,7 +1,6 @@
 #include "operator_data_fetcher.hpp"
+#include "parsers/binary_batch.hpp"
 #include <userver/clients/http/component.hpp>
-#include <userver/formats/json/parse.hpp>
-#include <userver/formats/json/value.hpp>
 #include <userver/logging/log.hpp>
 
 namespace call_flow_processor::components::data_fetchers {
@@ -13,6 +12,7 @@ OperatorDataFetcher::OperatorDataFetcher(
 : DataFetcherBase<models::Operator>(config, context),
   http_client_(context.FindComponent<userver::clients::http::Client>("http-client")),
   operator_controller_(context.FindComponent<controllers::OperatorController>("operator-controller")),
+  operator_cache_(context.FindComponent<caches::OperatorCache>()),
   endpoint_(config["source-endpoint"].As<std::string>()),
   fetch_limit_(config["fetch-limit"].As<int>(100))
 {}
@@ -21,14 +21,15 @@ std::string OperatorDataFetcher::GetId() {
     return "operator-data-fetcher";
 }
 
-std::vector<models::Operator> OperatorDataFetcher::Fetch(std::int64_t cursor) {
-    std::vector<models::Operator> result;
+FetchResult<models::Operator> OperatorDataFetcher::Fetch(std::int64_t cursor, int partition) {
+    FetchResult<models::Operator> result;
     try {
         const auto url = endpoint_ + "?cursor=" + std::to_string(cursor)
-            + "&limit=" + std::to_string(fetch_limit_);
+            + "&limit=" + std::to_string(fetch_limit_) + PartitionQuery(partition);
 
         auto response = http_client_.CreateRequest()
             .get(url)
+            .header("Accept", std::string{parsers::kBatchAccept})
             .timeout(std::chrono::seconds(10))
             .perform();
 
@@ -38,37 +39,35 @@ std::vector<models::Operator> OperatorDataFetcher::Fetch(std::int64_t cursor) {
             return result;
         }
 
-        const auto json = userver::formats::json::FromString(response->body);
-
-        if (!json.IsArray()) {
-            LOG_ERROR() << "OperatorDataFetcher fetch: response is not array";
-            return result;
-        }
-
-        for (const auto& item : json) {
-            try {
-                models::Operator op;
-                op.operator_id = item["operator_id"].As<std::int64_t>();
-                op.name = item["name"].As<std::string>();
-                op.extension = item["extension"].As<std::string>();
-                op.email = item["email"].As<std::string>();
-                result.emplace_back(std::move(op));
-            } catch (const std::exception& ex) {
-                LOG_ERROR() << "OperatorDataFetcher failed to parse row: " << ex.what();
-            }
-        }
+        std::vector<models::Operator> items;
+        items.reserve(fetch_limit_);
+        const auto page = parsers::DecodePage(ResponseContentType(*response), response->body, items);
+        result.items = std::move(items);
+        result.has_more = page.has_next_cursor
+            || page.item_count >= static_cast<std::size_t>(fetch_limit_);
     } catch (const std::exception& ex) {
         LOG_ERROR() << "OperatorDataFetcher fetch failed: " << ex.what();
     }
     return result;
 }
 
-void OperatorDataFetcher::Store(std::vector<models::Operator>&& data) {
-    try {
-        operator_controller_.Save(std::move(data));
-    } catch (const std::exception& ex) {
-        LOG_ERROR() << "OperatorDataFetcher store failed: " << ex.what();
-    }
+std::vector<std::int64_t> OperatorDataFetcher::Store(
+    userver::storages::postgres::Transaction& trx, std::vector<models::Operator>&& data) {
+    operator_controller_.Save(trx, std::move(data));
+    return {};
+}
+
+void OperatorDataFetcher::Stage(std::vector<models::Operator>&& data) {
+    operator_controller_.Stage(std::move(data));
+}
+
+std::vector<std::int64_t> OperatorDataFetcher::MergeStaged(userver::storages::postgres::Transaction& trx) {
+    operator_controller_.MergeStaged(trx);
+    return {};
+}
+
+void OperatorDataFetcher::OnCommitted() {
+    operator_cache_.InvalidateAsync(userver::cache::UpdateType::kIncremental);
 }
 
 }  // namespace call_flow_processor::components::data_fetchers
@@ -2,6 +2,7 @@
 
 #include "data_fetcher_base.hpp"
 #include "models/operator.hpp"
+#include "components/caches/operator_cache.hpp"
 #include "components/controllers/operator_controller.hpp"
 #include <userver/clients/http/client.hpp>
 #include <string>
@@ -18,11 +19,16 @@ public:
 
 protected:
     std::string GetId() override;
-    std::vector<models::Operator> Fetch(std::int64_t cursor) override;
-    void Store(std::vector<models::Operator>&& data) override;
+    FetchResult<models::Operator> Fetch(std::int64_t cursor, int partition) override;
+    std::vector<std::int64_t> Store(
+        userver::storages::postgres::Transaction& trx, std::vector<models::Operator>&& data) override;
+    void Stage(std::vector<models::Operator>&& data) override;
+    std::vector<std::int64_t> MergeStaged(userver::storages::postgres::Transaction& trx) override;
+    void OnCommitted() override;
 
     userver::clients::http::Client& http_client_;
     controllers::OperatorController& operator_controller_;
+    caches::OperatorCache& operator_cache_;
     std::string endpoint_;
     int fetch_limit_;
 };
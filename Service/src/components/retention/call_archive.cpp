@@ -0,0 +1,210 @@
+#include "call_archive.hpp"
+#include <userver/engine/async.hpp>
+#include <userver/utils/datetime.hpp>
+#include <userver/utils/uuid4.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cerrno>
+#include <ctime>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+namespace call_flow_processor::components {
+
+namespace {
+
+// windowBits 15 + 16 makes zlib write and read gzip framing.
+constexpr int kGzipWindowBits = 15 + 16;
+
+std::string GzipCompress(const std::string& data) {
+    z_stream stream{};
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, kGzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("deflateInit2 failed");
+    }
+    std::string out(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = out.size();
+    const int status = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (status != Z_STREAM_END) throw std::runtime_error("deflate failed");
+    return out;
+}
+
+std::string GzipDecompress(const std::string& data) {
+    z_stream stream{};
+    if (inflateInit2(&stream, kGzipWindowBits) != Z_OK) throw std::runtime_error("inflateInit2 failed");
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+
+    std::string out;
+    char buffer[64 * 1024];
+    int status = Z_OK;
+    while (status == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END) throw std::runtime_error("archive chunk is corrupted");
+    return out;
+}
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr const char* kVolumeIdFile = ".volume-id";
+
+void WriteAll(int fd, const std::string& data, const std::string& path) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        const auto result = ::write(fd, data.data() + written, data.size() - written);
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0) {
+            ::close(fd);
+            ThrowErrno("write " + path);
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+// Empty if the file does not exist.
+std::string ReadVolumeId(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 && errno == ENOENT) return {};
+    if (fd < 0) ThrowErrno("open " + path);
+    char buffer[128];
+    ssize_t result = 0;
+    do {
+        result = ::read(fd, buffer, sizeof(buffer));
+    } while (result < 0 && errno == EINTR);
+    ::close(fd);
+    if (result < 0) ThrowErrno("read " + path);
+    return std::string(buffer, result);
+}
+
+std::string DayFileName() {
+    const auto now = std::chrono::system_clock::to_time_t(userver::utils::datetime::Now());
+    std::tm tm{};
+    gmtime_r(&now, &tm);
+    char name[32];
+    std::strftime(name, sizeof(name), "calls-%Y%m%d.jsonl.gz", &tm);
+    return name;
+}
+
+}  // namespace
+
+CallArchive::CallArchive(std::string directory, userver::engine::TaskProcessor& fs_task_processor)
+    : directory_(std::move(directory)), fs_task_processor_(fs_task_processor) {}
+
+ArchiveLocation CallArchive::Append(const std::vector<std::string>& records) {
+    std::string chunk;
+    for (const auto& record : records) {
+        chunk += record;
+        chunk += '\n';
+    }
+    const auto member = GzipCompress(chunk);
+
+    const std::lock_guard lock(append_mutex_);
+    ArchiveLocation location{DayFileName(), 0, static_cast<std::int64_t>(member.size())};
+    const auto path = directory_ + "/" + location.file;
+    userver::engine::AsyncNoSpan(fs_task_processor_, [&] {
+        std::filesystem::create_directories(directory_);
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) ThrowErrno("open " + path);
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            ThrowErrno("stat " + path);
+        }
+        location.offset = info.st_size;
+
+        WriteAll(fd, member, path);
+        if (::fsync(fd) != 0) {
+            ::close(fd);
+            ThrowErrno("fsync " + path);
+        }
+        ::close(fd);
+    }).Get();
+    return location;
+}
+
+std::vector<std::string> CallArchive::Read(const ArchiveLocation& location) const {
+    const auto path = directory_ + "/" + location.file;
+    std::string member(location.length, '\0');
+    userver::engine::AsyncNoSpan(fs_task_processor_, [&] {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) ThrowErrno("open " + path);
+        std::size_t read = 0;
+        while (read < member.size()) {
+            const auto result = ::pread(fd, member.data() + read, member.size() - read, location.offset + read);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) {
+                ::close(fd);
+                if (result == 0) throw std::runtime_error("archive chunk is truncated in " + path);
+                ThrowErrno("read " + path);
+            }
+            read += static_cast<std::size_t>(result);
+        }
+        ::close(fd);
+    }).Get();
+
+    std::vector<std::string> records;
+    const auto chunk = GzipDecompress(member);
+    std::size_t begin = 0;
+    while (begin < chunk.size()) {
+        auto end = chunk.find('\n', begin);
+        if (end == std::string::npos) end = chunk.size();
+        records.push_back(chunk.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return records;
+}
+
+std::string CallArchive::VolumeId() const {
+    const std::lock_guard lock(volume_id_mutex_);
+    if (!volume_id_.empty()) return volume_id_;
+
+    const auto path = directory_ + "/" + kVolumeIdFile;
+    userver::engine::AsyncNoSpan(fs_task_processor_, [&] {
+        volume_id_ = ReadVolumeId(path);
+        if (!volume_id_.empty()) return;
+
+        // The id is written under a name of its own and linked into place,
+        // so of instances racing to create it one wins and none reads a
+        // partly written file.
+        std::filesystem::create_directories(directory_);
+        const auto candidate = userver::utils::generators::GenerateUuid();
+        const auto candidate_path = path + "." + candidate;
+        const int fd = ::open(candidate_path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0) ThrowErrno("open " + candidate_path);
+        WriteAll(fd, candidate, candidate_path);
+        if (::fsync(fd) != 0) {
+            ::close(fd);
+            ThrowErrno("fsync " + candidate_path);
+        }
+        ::close(fd);
+        const bool linked = ::link(candidate_path.c_str(), path.c_str()) == 0;
+        const int link_errno = errno;
+        ::unlink(candidate_path.c_str());
+        if (!linked && link_errno != EEXIST) {
+            errno = link_errno;
+            ThrowErrno("link " + path);
+        }
+        volume_id_ = ReadVolumeId(path);
+    }).Get();
+    if (volume_id_.empty()) throw std::runtime_error("archive volume id is empty in " + path);
+    return volume_id_;
+}
+
+} // namespace call_flow_processor::components
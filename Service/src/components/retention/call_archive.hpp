@@ -0,0 +1,48 @@
+#pragma once
+
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace call_flow_processor::components {
+
+// Where a chunk of archived calls went: file is relative to the archive
+// directory, offset and length locate the chunk's gzip member.
+struct ArchiveLocation {
+    std::string file;
+    std::int64_t offset{0};
+    std::int64_t length{0};
+};
+
+// Append-only archive of calls. Every chunk becomes one gzip member holding
+// one JSON document per line, appended to a file per UTC day, so each file
+// is a valid .jsonl.gz as a whole and a single chunk can be read back
+// without the rest. File I/O runs on the fs task processor.
+//
+// Chunks are read back by whichever instance serves the request, so the
+// directory must be a volume shared by all instances. The first one to use
+// it stores a random volume id in it; instances that see a different id
+// have a directory of their own.
+class CallArchive final {
+public:
+    CallArchive(std::string directory, userver::engine::TaskProcessor& fs_task_processor);
+
+    // The location is durable once this returns: the file is fsync'ed.
+    ArchiveLocation Append(const std::vector<std::string>& records);
+
+    std::vector<std::string> Read(const ArchiveLocation& location) const;
+
+    // Id of the volume the directory is on; created on first use.
+    std::string VolumeId() const;
+
+private:
+    const std::string directory_;
+    userver::engine::TaskProcessor& fs_task_processor_;
+    userver::engine::Mutex append_mutex_;
+    mutable userver::engine::Mutex volume_id_mutex_;
+    mutable std::string volume_id_;
+};
+
+} // namespace call_flow_processor::components
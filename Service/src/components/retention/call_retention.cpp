@@ -0,0 +1,218 @@
+#include "call_retention.hpp"
+#include <userver/components/statistics_storage.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+#include <userver/formats/json/serialize.hpp>
+#include <userver/formats/json/value.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/storages/postgres/component.hpp>
+#include <userver/utils/statistics/writer.hpp>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace call_flow_processor::components {
+
+namespace {
+
+// Tables partitioned by id, see V003__id_range_partitions.sql.
+constexpr const char* kPartitionedTables[] = {"calls", "connections", "call_events"};
+
+// A call counts as uploaded once every cdr_type of $3 has an 'uploaded'
+// row for it; a missing row means that uploader has not taken it yet.
+constexpr const char* kSelectExpired =
+    "SELECT c.call_id FROM calls c "
+    "WHERE c.finished_at < now() - $1::bigint * interval '1 second' "
+    "AND (SELECT count(*) FROM cdr_upload_info u "
+    "WHERE u.call_id = c.call_id AND u.cdr_type = ANY($3) AND u.upload_status = 'uploaded') "
+    "= cardinality($3::text[]) "
+    "ORDER BY c.finished_at LIMIT $2;";
+
+constexpr const char* kSelectDocuments =
+    "SELECT json_build_object("
+    "'call_id', c.call_id, "
+    "'call', row_to_json(c), "
+    "'connections', COALESCE((SELECT json_agg(x) FROM connections x WHERE x.call_id = c.call_id), '[]'::json), "
+    "'call_events', COALESCE((SELECT json_agg(e) FROM call_events e WHERE e.call_id = c.call_id), '[]'::json), "
+    "'cdr_upload_info', COALESCE((SELECT json_agg(u) FROM cdr_upload_info u WHERE u.call_id = c.call_id), '[]'::json)"
+    ")::text FROM calls c WHERE c.call_id = ANY($1);";
+
+constexpr const char* kRecordArchived =
+    "INSERT INTO archived_calls (call_id, archive_file, archive_offset, archive_length) "
+    "SELECT UNNEST($1::bigint[]), $2, $3, $4 "
+    "ON CONFLICT (call_id) DO UPDATE SET archive_file = EXCLUDED.archive_file, "
+    "archive_offset = EXCLUDED.archive_offset, archive_length = EXCLUDED.archive_length, "
+    "archived_at = EXCLUDED.archived_at;";
+
+// Registers volume $1 unless one already is, and returns the registered one.
+constexpr const char* kRegisterArchiveVolume =
+    "WITH registered AS ("
+    "INSERT INTO archive_volume (volume_id) VALUES ($1) ON CONFLICT DO NOTHING RETURNING volume_id) "
+    "SELECT volume_id FROM registered UNION ALL SELECT volume_id FROM archive_volume LIMIT 1;";
+
+constexpr const char* kSelectArchived =
+    "SELECT a.archive_file, a.archive_offset, a.archive_length, v.volume_id "
+    "FROM archived_calls a LEFT JOIN archive_volume v ON TRUE WHERE a.call_id = $1;";
+
+void CheckArchiveVolume(const std::string& registered, const std::string& own) {
+    if (registered == own) return;
+    throw std::runtime_error(
+        "CallRetention: archive-dir is on volume " + own + ", but the archive is on volume " + registered +
+        "; archive-dir must be the volume shared by all instances");
+}
+
+// Children first, the foreign keys point at calls.
+constexpr const char* kDeleteArchived[] = {
+    "DELETE FROM cdr_upload_info WHERE call_id = ANY($1);",
+    "DELETE FROM call_events WHERE call_id = ANY($1);",
+    "DELETE FROM connections WHERE call_id = ANY($1);",
+    "DELETE FROM finished_calls WHERE call_id = ANY($1);",
+    "DELETE FROM calls WHERE call_id = ANY($1);",
+};
+
+}  // namespace
+
+const char* CallRetention::kName = "call-retention";
+
+CallRetention::CallRetention(const userver::components::ComponentConfig& config,
+                             const userver::components::ComponentContext& context)
+    : userver::storages::postgres::DistLockComponentBase(config, context),
+      pg_{context.FindComponent<userver::components::Postgres>("postgres").GetCluster()},
+      archive_{config["archive-dir"].As<std::string>(),
+               context.GetTaskProcessor(config["fs-task-processor"].As<std::string>("fs-task-processor"))},
+      max_age_{config["max-age-hours"].As<std::int64_t>(720) * 3600},
+      chunk_size_{config["chunk-size"].As<std::size_t>(1000)},
+      max_chunks_per_run_{config["max-chunks-per-run"].As<int>(100)},
+      chunk_pause_{config["chunk-pause-ms"].As<std::int64_t>(100)},
+      run_interval_{config["run-interval-ms"].As<std::int64_t>(600000)},
+      partitions_ahead_{config["partitions-ahead"].As<int>(4)},
+      cdr_types_{config["cdr-types"].As<std::vector<std::string>>()} {
+    if (cdr_types_.empty()) {
+        throw std::runtime_error("call-retention: cdr-types must list the CDR uploaders");
+    }
+    statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>()
+        .GetStorage()
+        .RegisterWriter(
+            "call-retention",
+            [this](userver::utils::statistics::Writer& writer) {
+                writer["archived-calls"] = archived_calls_.load();
+                writer["dropped-partitions"] = dropped_partitions_.load();
+            });
+    AutostartDistLock();
+}
+
+CallRetention::~CallRetention() {
+    StopDistLock();
+    statistics_holder_.Unregister();
+}
+
+void CallRetention::DoWork() {
+    while (!userver::engine::current_task::IsCancelRequested()) {
+        try {
+            RunOnce();
+        } catch (const std::exception& e) {
+            // Whatever was not deleted is simply picked up by the next run.
+            LOG_ERROR() << "CallRetention run failed: " << e.what();
+        }
+        userver::engine::InterruptibleSleepFor(run_interval_);
+    }
+}
+
+void CallRetention::DoWorkTestsuite() { RunOnce(); }
+
+void CallRetention::RunOnce() {
+    // Archiving into a directory other instances cannot read would make
+    // the calls unreachable through them, so it is refused.
+    const auto own_volume = archive_.VolumeId();
+    CheckArchiveVolume(
+        pg_->Execute(userver::storages::postgres::ClusterHostType::kMaster, kRegisterArchiveVolume, own_volume)
+            .AsSingleRow<std::string>(),
+        own_volume);
+
+    for (int chunk = 0; chunk < max_chunks_per_run_; ++chunk) {
+        if (userver::engine::current_task::IsCancelRequested()) return;
+        if (ArchiveChunk() < chunk_size_) break;
+        userver::engine::InterruptibleSleepFor(chunk_pause_);
+    }
+    MaintainPartitions();
+}
+
+std::size_t CallRetention::ArchiveChunk() {
+    const auto call_ids = pg_->Execute(
+        userver::storages::postgres::ClusterHostType::kMaster,
+        kSelectExpired,
+        static_cast<std::int64_t>(max_age_.count()), static_cast<std::int64_t>(chunk_size_), cdr_types_
+    ).AsContainer<std::vector<std::int64_t>>();
+    if (call_ids.empty()) return 0;
+
+    const auto documents = pg_->Execute(
+        userver::storages::postgres::ClusterHostType::kMaster,
+        kSelectDocuments,
+        call_ids
+    ).AsContainer<std::vector<std::string>>();
+
+    // The chunk is on disk before anything is deleted. If the transaction
+    // below fails, the chunk stays in the file unreferenced and the calls
+    // are archived again by the next run.
+    const auto location = archive_.Append(documents);
+
+    auto trx = pg_->Begin(userver::storages::postgres::ClusterHostType::kMaster);
+    trx.Execute(kRecordArchived, call_ids, location.file, location.offset, location.length);
+    for (const auto* query : kDeleteArchived) trx.Execute(query, call_ids);
+    trx.Commit();
+
+    archived_calls_ += call_ids.size();
+    LOG_INFO() << "CallRetention archived " << call_ids.size() << " calls to " << location.file;
+    return call_ids.size();
+}
+
+void CallRetention::MaintainPartitions() {
+    for (const auto* table : kPartitionedTables) {
+        pg_->Execute(
+            userver::storages::postgres::ClusterHostType::kMaster,
+            "SELECT call_flow_processor.ensure_id_partitions($1, $2);",
+            std::string{table}, partitions_ahead_
+        );
+        const auto dropped = pg_->Execute(
+            userver::storages::postgres::ClusterHostType::kMaster,
+            "SELECT call_flow_processor.drop_empty_id_partitions($1);",
+            std::string{table}
+        ).AsSingleRow<int>();
+        if (dropped > 0) {
+            dropped_partitions_ += dropped;
+            LOG_INFO() << "CallRetention dropped " << dropped << " empty partitions of " << table;
+        }
+    }
+}
+
+std::optional<std::string> CallRetention::FindArchived(std::int64_t call_id) const {
+    try {
+        const auto result = pg_->Execute(
+            userver::storages::postgres::ClusterHostType::kSlave,
+            kSelectArchived,
+            call_id
+        );
+        if (result.IsEmpty()) return std::nullopt;
+        const auto volume = result[0]["volume_id"].As<std::optional<std::string>>();
+        if (volume) CheckArchiveVolume(*volume, archive_.VolumeId());
+
+        ArchiveLocation location;
+        location.file = result[0]["archive_file"].As<std::string>();
+        location.offset = result[0]["archive_offset"].As<std::int64_t>();
+        location.length = result[0]["archive_length"].As<std::int64_t>();
+
+        for (auto& document : archive_.Read(location)) {
+            const auto json = userver::formats::json::FromString(document);
+            if (json["call_id"].As<std::int64_t>() == call_id) return std::move(document);
+        }
+        LOG_ERROR() << "CallRetention: call " << call_id << " is missing from its archive chunk in "
+                    << location.file;
+        return std::nullopt;
+    } catch (const std::exception& ex) {
+        LOG_ERROR() << "CallRetention FindArchived error: " << ex.what();
+        throw;
+    }
+}
+
+} // namespace call_flow_processor::components
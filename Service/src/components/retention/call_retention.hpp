@@ -0,0 +1,74 @@
+#pragma once
+
+#include <userver/storages/postgres/dist_lock_component_base.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/storages/postgres/cluster.hpp>
+#include <userver/utils/statistics/entry.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "components/retention/call_archive.hpp"
+
+namespace call_flow_processor::components {
+
+// Moves old calls out of the database. A call whose CDRs are uploaded by
+// every uploader listed in cdr-types and that finished more than
+// max-age-hours ago is written to the CallArchive together with its
+// connections, events and upload status. It is then deleted from all tables in the same transaction that
+// records its archive location in archived_calls. Work is done in chunks
+// of chunk-size calls, at most max-chunks-per-run per run, with a pause in
+// between, so the deletes never hold many locks or build up a long
+// transaction.
+//
+// archive-dir must be a volume shared by all instances: the archive is
+// written by the lock holder but read by whichever instance serves
+// FindArchived(). The first run registers the volume in archive_volume; an
+// instance whose archive-dir is on another volume neither archives nor
+// serves archived calls.
+//
+// Each run also keeps new id partitions ready ahead of the data and drops
+// old partitions the deletes have emptied.
+class CallRetention final : public userver::storages::postgres::DistLockComponentBase {
+public:
+    static constexpr const char* kName;
+
+    CallRetention(const userver::components::ComponentConfig& config,
+                  const userver::components::ComponentContext& context);
+    ~CallRetention() override;
+
+    // The archived document of call_id, if the call was archived.
+    std::optional<std::string> FindArchived(std::int64_t call_id) const;
+
+protected:
+    void DoWork() override;
+    // One run per distlock/call-retention testsuite task.
+    void DoWorkTestsuite() override;
+
+private:
+    void RunOnce();
+    // Returns the number of calls archived.
+    std::size_t ArchiveChunk();
+    void MaintainPartitions();
+
+    userver::storages::postgres::ClusterPtr pg_;
+    CallArchive archive_;
+    const std::chrono::seconds max_age_;
+    const std::size_t chunk_size_;
+    const int max_chunks_per_run_;
+    const std::chrono::milliseconds chunk_pause_;
+    const std::chrono::milliseconds run_interval_;
+    const int partitions_ahead_;
+    // GetId() of every CDR uploader; a call is kept until all of them
+    // uploaded it.
+    const std::vector<std::string> cdr_types_;
+
+    std::atomic<std::int64_t> archived_calls_{0};
+    std::atomic<std::int64_t> dropped_partitions_{0};
+    userver::utils::statistics::Entry statistics_holder_;
+};
+
+} // namespace call_flow_processor::components
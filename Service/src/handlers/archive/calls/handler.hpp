@@ -0,0 +1,55 @@
+#pragma once
+
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/logging/log.hpp>
+
+#include "components/retention/call_retention.hpp"
+
+#include <string>
+
+namespace call_flow_processor::handlers {
+
+// GET /archive/calls?call_id=N returns the document CallRetention archived
+// for the call: the call row with its connections, events and upload
+// status, as they were when the call was archived.
+class ArchivedCallHandler final
+    : public userver::server::handlers::HttpHandlerBase {
+ public:
+  static constexpr std::string_view kName = "handler-archive-calls";
+
+  ArchivedCallHandler(const userver::components::ComponentConfig& config,
+                      const userver::components::ComponentContext& context)
+      : userver::server::handlers::HttpHandlerBase(config, context),
+        retention_(context.FindComponent<components::CallRetention>("call-retention")) {}
+
+  std::string HandleRequestThrow(
+      const userver::server::http::HttpRequest& request,
+      userver::server::request::RequestContext&) const override {
+    std::int64_t call_id = 0;
+    try {
+      call_id = std::stoll(request.GetArg("call_id"));
+    } catch (const std::exception&) {
+      request.SetResponseStatus(userver::server::http::HttpStatus::kBadRequest);
+      return R"({"error":"call_id must be an integer"})";
+    }
+
+    try {
+      auto document = retention_.FindArchived(call_id);
+      if (!document) {
+        request.SetResponseStatus(userver::server::http::HttpStatus::kNotFound);
+        return R"({"error":"call is not archived"})";
+      }
+      request.GetHttpResponse().SetContentType("application/json");
+      return std::move(*document);
+    } catch (const std::exception& e) {
+      LOG_ERROR() << "ArchivedCallHandler exception: " << e.what();
+      throw;
+    }
+  }
+
+ private:
+  const components::CallRetention& retention_;
+};
+
+}  // namespace call_flow_processor::handlers
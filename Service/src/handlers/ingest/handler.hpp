@@ -0,0 +1,150 @@
+#pragma once
+
+#include <userver/server/handlers/http_handler_base.hpp>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/engine/semaphore.hpp>
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/storages/postgres/exceptions.hpp>
+
+#include "components/controllers/call_controller.hpp"
+#include "components/controllers/call_event_controller.hpp"
+#include "components/controllers/connection_controller.hpp"
+#include "components/controllers/operator_controller.hpp"
+#include "models/call.hpp"
+#include "models/call_event.hpp"
+#include "models/connection.hpp"
+#include "models/operator.hpp"
+#include "parsers/binary_batch.hpp"
+#include "parsers/json_reader.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace call_flow_processor::handlers {
+
+// Accepts batches pushed by upstream producers, in the same format the
+// data fetchers read from the sources: a JSON array of rows, an object with
+// a "results" array, or a binary batch (Content-Type
+// application/x-cfp-batch). Rows go through the controller's Save(), the same
+// path the fetchers use.
+//
+// The body size is bounded by the handler's max_request_size, the row count
+// by max-batch-rows, which stops decoding as soon as it is exceeded. At most
+// max-concurrent-writes batches are written at a time; further requests,
+// and requests that find the Postgres pool exhausted, get 429 so the
+// producer retries later instead of queueing up.
+template <class T, class Controller>
+class IngestHandlerBase : public userver::server::handlers::HttpHandlerBase {
+ public:
+  IngestHandlerBase(const userver::components::ComponentConfig& config,
+                    const userver::components::ComponentContext& context,
+                    std::string_view controller_name)
+      : userver::server::handlers::HttpHandlerBase(config, context),
+        controller_(context.FindComponent<Controller>(controller_name)),
+        max_batch_rows_(config["max-batch-rows"].As<std::size_t>(5000)),
+        write_slots_(config["max-concurrent-writes"].As<std::size_t>(4)) {}
+
+  std::string HandleRequestThrow(
+      const userver::server::http::HttpRequest& request,
+      userver::server::request::RequestContext&) const override {
+    std::shared_lock<userver::engine::Semaphore> slot(write_slots_, std::try_to_lock);
+    if (!slot) return Overloaded(request);
+
+    std::vector<T> items;
+    parsers::PageInfo page;
+    try {
+      // Stops at the row limit instead of decoding an oversized batch first.
+      page = parsers::DecodePage(request.GetHeader("Content-Type"), request.RequestBody(), items,
+                                 max_batch_rows_);
+    } catch (const parsers::TooManyRowsError& e) {
+      return Error(request, userver::server::http::HttpStatus::kPayloadTooLarge, e.what());
+    } catch (const parsers::JsonParseError& e) {
+      return Error(request, userver::server::http::HttpStatus::kBadRequest, e.what());
+    } catch (const parsers::BinaryBatchError& e) {
+      return Error(request, userver::server::http::HttpStatus::kBadRequest, e.what());
+    }
+
+    const auto accepted = items.size();
+    try {
+      if (!items.empty()) controller_.Save(std::move(items));
+    } catch (const userver::storages::postgres::PoolError& e) {
+      LOG_WARNING() << "Ingest rejected, postgres pool exhausted: " << e.what();
+      return Overloaded(request);
+    } catch (const std::exception& e) {
+      LOG_ERROR() << "Ingest batch store failed: " << e.what();
+      throw;
+    }
+
+    userver::formats::json::ValueBuilder builder;
+    builder["accepted"] = accepted;
+    builder["rejected"] = page.rejected_count;
+    return userver::formats::json::ToString(builder.ExtractValue());
+  }
+
+ private:
+  static std::string Error(const userver::server::http::HttpRequest& request,
+                           userver::server::http::HttpStatus status,
+                           const std::string& message) {
+    request.SetResponseStatus(status);
+    userver::formats::json::ValueBuilder builder;
+    builder["message"] = message;
+    return userver::formats::json::ToString(builder.ExtractValue());
+  }
+
+  static std::string Overloaded(const userver::server::http::HttpRequest& request) {
+    request.GetHttpResponse().SetHeader(std::string{"Retry-After"}, "1");
+    return Error(request, userver::server::http::HttpStatus::kTooManyRequests,
+                 "write path is saturated, retry later");
+  }
+
+  Controller& controller_;
+  const std::size_t max_batch_rows_;
+  mutable userver::engine::Semaphore write_slots_;
+};
+
+class IngestCallsHandler final
+    : public IngestHandlerBase<models::Call, components::controllers::CallController> {
+ public:
+  static constexpr std::string_view kName = "handler-ingest-calls";
+
+  IngestCallsHandler(const userver::components::ComponentConfig& config,
+                     const userver::components::ComponentContext& context)
+      : IngestHandlerBase(config, context, "call-controller") {}
+};
+
+class IngestConnectionsHandler final
+    : public IngestHandlerBase<models::Connection, components::controllers::ConnectionController> {
+ public:
+  static constexpr std::string_view kName = "handler-ingest-connections";
+
+  IngestConnectionsHandler(const userver::components::ComponentConfig& config,
+                           const userver::components::ComponentContext& context)
+      : IngestHandlerBase(config, context, "connection-controller") {}
+};
+
+class IngestCallEventsHandler final
+    : public IngestHandlerBase<models::CallEvent, components::controllers::CallEventController> {
+ public:
+  static constexpr std::string_view kName = "handler-ingest-call-events";
+
+  IngestCallEventsHandler(const userver::components::ComponentConfig& config,
+                          const userver::components::ComponentContext& context)
+      : IngestHandlerBase(config, context, "call-event-controller") {}
+};
+
+class IngestOperatorsHandler final
+    : public IngestHandlerBase<models::Operator, components::controllers::OperatorController> {
+ public:
+  static constexpr std::string_view kName = "handler-ingest-operators";
+
+  IngestOperatorsHandler(const userver::components::ComponentConfig& config,
+                         const userver::components::ComponentContext& context)
+      : IngestHandlerBase(config, context, "operator-controller") {}
+};
+
+}  // namespace call_flow_processor::handlers
@@ -33,10 +33,12 @@ class StatisticsCallsSummaryHandler final
       double total_duration_seconds = 0.0;
 
       for (const auto& call : calls) {
-        if (call.status == "answered") ++answered_calls;
+        if (call.status == models::symbols::kAnswered) ++answered_calls;
+
+        if (!call.finished_at) continue;
 
         using namespace std::chrono;
-        auto duration = call.finished_at - call.started_at;
+        auto duration = *call.finished_at - call.started_at;
         total_duration_seconds += duration.count();
       }
 
@@ -7,7 +7,7 @@
 #include <unordered_map>
 #include <cmath>
 
-#include "components/controllers/operator_controller.hpp"
+#include "components/caches/operator_cache.hpp"
 #include "components/controllers/call_controller.hpp"
 #include "models/operator.hpp"
 #include "models/call.hpp"
@@ -22,7 +22,7 @@ class StatisticsOperatorsHandler final
   StatisticsOperatorsHandler(const userver::components::ComponentConfig& config,
                             const userver::components::ComponentContext& context)
       : userver::server::handlers::HttpHandlerBase(config, context),
-        operator_controller_(context.FindComponent<components::controllers::OperatorController>("operator-controller")),
+        operator_cache_(context.FindComponent<components::caches::OperatorCache>()),
         call_controller_(context.FindComponent<components::controllers::CallController>("call-controller")) {}
 
   std::string HandleRequestThrow(
@@ -31,10 +31,8 @@ class StatisticsOperatorsHandler final
 
     try {
       
-      std::vector<call_flow_processor::models::Operator> operators = operator_controller_.GetAllOperators();
-      
-      std::unordered_map<std::int64_t, call_flow_processor::models::Operator> op_map;
-      for (const auto& op : operators) op_map[op.operator_id] = op;
+      const auto operators = operator_cache_.Get();
+      const auto& op_map = *operators;
 
       std::vector<call_flow_processor::models::Call> calls = call_controller_.GetAllCallsWithFinishTime();
 
@@ -49,11 +47,12 @@ class StatisticsOperatorsHandler final
         std::int64_t op_id = call.user_id;
         auto it = op_map.find(op_id);
         if (it == op_map.end()) continue; // skip calls without operator
+        if (!call.finished_at) continue;
         auto& stat = stats[op_id];
         stat.name = it->second.name;
 
         using namespace std::chrono;
-        double duration = (call.finished_at - call.started_at).count();
+        double duration = (*call.finished_at - call.started_at).count();
         ++stat.count;
         stat.total_duration += duration;
       }
@@ -79,7 +78,7 @@ class StatisticsOperatorsHandler final
   }
 
  private:
-  components::controllers::OperatorController& operator_controller_;
+  const components::caches::OperatorCache& operator_cache_;
   components::controllers::CallController& call_controller_;
 };
 
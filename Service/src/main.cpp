@@ -6,11 +6,15 @@
 #include <userver/storages/postgres/component.hpp>
 #include <userver/utils/daemon_run.hpp>
 #include <userver/clients/dns/component.hpp>
+#include <userver/components/dump_configurator.hpp>
 #include <userver/components/fs_cache.hpp>
 
+#include "components/caches/operator_cache.hpp"
+#include "components/cdr_uploaders/call_snapshots.hpp"
 #include "components/cdr_uploaders/cdr_upload_info.hpp"
 #include "components/cdr_uploaders/cdr_uploader.hpp"
 #include "components/cdr_uploaders/external_cdr_uploader.hpp"
+#include "components/cdr_uploaders/finished_calls_channel.hpp"
 #include "components/controllers/call_controller.hpp"
 #include "components/controllers/call_event_controller.hpp"
 #include "components/controllers/connection_controller.hpp"
@@ -20,6 +24,9 @@
 #include "components/data_fetchers/call_event_data_fetcher.hpp"
 #include "components/data_fetchers/connection_data_fetcher.hpp"
 #include "components/data_fetchers/operator_data_fetcher.hpp"
+#include "components/retention/call_retention.hpp"
+#include "handlers/archive/calls/handler.hpp"
+#include "handlers/ingest/handler.hpp"
 #include "handlers/statistics/calls/summary/handler.hpp"
 #include "handlers/statistics/operators/handler.hpp"
 
@@ -31,9 +38,11 @@ int main(int argc, char* argv[]) {
     .Append<userver::components::HttpClient>()
     .Append<userver::components::Postgres>()
     .Append<userver::clients::dns::Component>()
-    .Append<userver::components::FsCache>();
+    .Append<userver::components::FsCache>()
+    .Append<userver::components::DumpConfigurator>();
 
   component_list
+    .Append<call_flow_processor::components::caches::OperatorCache>()
     .Append<call_flow_processor::components::controllers::CallController>()
     .Append<call_flow_processor::components::controllers::CallEventController>()
     .Append<call_flow_processor::components::controllers::ConnectionController>()
@@ -46,11 +55,20 @@ int main(int argc, char* argv[]) {
     .Append<call_flow_processor::components::data_fetchers::OperatorDataFetcher>()
 
     .Append<call_flow_processor::components::CDRUploadInfo>()
+    .Append<call_flow_processor::components::FinishedCallsChannel>()
+    .Append<call_flow_processor::components::CallSnapshots>()
     .Append<call_flow_processor::components::CDRUploader>()
     .Append<call_flow_processor::components::ExternalCDRUploader>()
+    .Append<call_flow_processor::components::CallRetention>()
 
     .Append<call_flow_processor::handlers::StatisticsCallsSummaryHandler>()
     .Append<call_flow_processor::handlers::StatisticsOperatorsHandler>()
+
+    .Append<call_flow_processor::handlers::IngestCallsHandler>()
+    .Append<call_flow_processor::handlers::IngestConnectionsHandler>()
+    .Append<call_flow_processor::handlers::IngestCallEventsHandler>()
+    .Append<call_flow_processor::handlers::IngestOperatorsHandler>()
+    .Append<call_flow_processor::handlers::ArchivedCallHandler>()
     ;
 
   return userver::utils::DaemonMain(argc, argv, component_list);
@@ -1,20 +1,22 @@
 #pragma once
 
+#include <optional>
+#include <string>
 #include <userver/storages/postgres/io/chrono.hpp>
+#include "models/symbol.hpp"
 
 
 namespace call_flow_processor::models {
 
 
 struct Call {
-    std::int64_t call_id;                         
-    std::string call_type;                        
-    std::string scenario_id;                      
-    std::string initiator_phone;                  
-    std::string media_record_id;                  
-    userver::storages::postgres::TimePointTz initiated_at;
+    std::int64_t id;
+    Symbol status;
+    userver::storages::postgres::TimePointTz started_at;
     std::optional<userver::storages::postgres::TimePointTz> finished_at;
-    userver::formats::json::Value context;
+    std::string caller_number;
+    std::string callee_number;
+    std::int64_t user_id;
 };
 
 }  // namespace call_flow_processor::models
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <userver/formats/json.hpp>
+#include <cstdint>
+#include <string>
+#include "models/symbol.hpp"
 
 namespace call_flow_processor::models {
 
@@ -8,8 +10,10 @@ namespace call_flow_processor::models {
 struct CallEvent {
     std::int64_t event_id;                
     std::int64_t call_id;                 
-    std::string event_type;               
-    userver::formats::json::Value payload;
+    Symbol event_type;
+    // Serialized JSON, kept as received from the source and parsed only by
+    // whoever needs its contents. Empty when the read did not project it.
+    std::string payload;
 };
 
 
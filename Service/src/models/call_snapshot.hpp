@@ -0,0 +1,20 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+#include "models/call.hpp"
+#include "models/call_event.hpp"
+#include "models/connection.hpp"
+#include "models/operator.hpp"
+
+namespace call_flow_processor::models {
+
+// Everything the CDR formats are built from for one finished call.
+struct CallSnapshot {
+    Call call;
+    std::optional<Operator> call_operator;
+    std::vector<CallEvent> events;
+    std::vector<Connection> connections;
+};
+
+} // namespace call_flow_processor::models
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <userver/storages/postgres/io/time_point_tz.hpp>
+#include "models/symbol.hpp"
 
 namespace call_flow_processor::models {
 
@@ -13,8 +14,8 @@ struct CDR {
     std::string caller_number;
     std::string callee_number;
     int duration_sec;
-    std::string call_result;
-    std::vector<std::string> call_events;
+    Symbol call_result;
+    std::vector<Symbol> call_events;
 };
 
 } // namespace call_flow_processor::models
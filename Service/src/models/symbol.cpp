@@ -0,0 +1,69 @@
+#include "symbol.hpp"
+
+#include <userver/logging/log.hpp>
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace call_flow_processor::models {
+
+// Entries live in a deque, so their addresses, and the string_views of the
+// index pointing into them, stay valid as the table grows. Lookups of known
+// values take the shared lock only; the section is a single hash lookup and
+// never suspends, so a plain std::shared_mutex is fine inside coroutines.
+class SymbolTable final {
+public:
+    static SymbolTable& Instance() {
+        static SymbolTable table;
+        return table;
+    }
+
+    const Symbol::Entry* Empty() const { return &entries_.front(); }
+
+    // nullptr once the table is full and value is not in it.
+    const Symbol::Entry* Intern(std::string_view value) {
+        {
+            const std::shared_lock lock(mutex_);
+            const auto it = index_.find(value);
+            if (it != index_.end()) return it->second;
+        }
+        const std::unique_lock lock(mutex_);
+        const auto it = index_.find(value);
+        if (it != index_.end()) return it->second;
+        if (entries_.size() >= Symbol::kMaxSymbols) {
+            if (!full_logged_) {
+                full_logged_ = true;
+                LOG_WARNING() << "Symbol table is full, values past " << Symbol::kMaxSymbols
+                              << " are no longer interned, first one: '" << value << "'";
+            }
+            return nullptr;
+        }
+        entries_.push_back(Symbol::Entry{static_cast<std::uint32_t>(entries_.size()), std::string(value)});
+        const auto& entry = entries_.back();
+        index_.emplace(entry.value, &entry);
+        return &entry;
+    }
+
+private:
+    SymbolTable() {
+        entries_.push_back(Symbol::Entry{0, std::string{}});
+        index_.emplace(entries_.front().value, &entries_.front());
+    }
+
+    std::shared_mutex mutex_;
+    bool full_logged_{false};
+    std::deque<Symbol::Entry> entries_;
+    std::unordered_map<std::string_view, const Symbol::Entry*> index_;
+};
+
+Symbol::Symbol() : entry_(SymbolTable::Instance().Empty()) {}
+
+Symbol::Symbol(std::string_view value) : entry_(SymbolTable::Instance().Intern(value)) {
+    if (entry_) return;
+    owned_ = std::make_shared<const Entry>(Entry{kUninterned, std::string(value)});
+    entry_ = owned_.get();
+}
+
+} // namespace call_flow_processor::models
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace call_flow_processor::models {
+
+// Interned string of one of the small, mostly closed domains of the
+// pipeline: event types, call statuses. Every distinct value is stored once
+// for the lifetime of the process, so a Symbol is a single pointer that
+// compares and hashes as an integer and copies without allocating. Values
+// unknown at compile time are interned as they arrive, up to kMaxSymbols
+// distinct ones, so a misbehaving source cannot grow the table without
+// bound. A new value past the cap still makes a valid Symbol: it owns its
+// string, with id kUninterned, and compares and hashes by that string.
+class Symbol final {
+public:
+    static constexpr std::size_t kMaxSymbols = 4096;
+    static constexpr std::uint32_t kUninterned = ~std::uint32_t{0};
+
+    // The empty symbol, id 0.
+    Symbol();
+    explicit Symbol(std::string_view value);
+
+    std::uint32_t Id() const { return entry_->id; }
+    const std::string& Str() const { return entry_->value; }
+    std::string_view View() const { return entry_->value; }
+    bool Empty() const { return entry_->id == 0; }
+    bool Interned() const { return !owned_; }
+
+    // A value is either interned or not, never both, so only two uninterned
+    // symbols need their strings compared.
+    friend bool operator==(const Symbol& lhs, const Symbol& rhs) {
+        return lhs.entry_ == rhs.entry_ || (lhs.owned_ && rhs.owned_ && lhs.Str() == rhs.Str());
+    }
+    friend bool operator!=(const Symbol& lhs, const Symbol& rhs) { return !(lhs == rhs); }
+
+private:
+    friend class SymbolTable;
+
+    struct Entry {
+        std::uint32_t id;
+        std::string value;
+    };
+
+    const Entry* entry_;
+    // Set for uninterned values only; entry_ points into it.
+    std::shared_ptr<const Entry> owned_;
+};
+
+// The values the pipeline branches on.
+namespace symbols {
+
+inline const Symbol kAnswered{"answered"};
+inline const Symbol kHangup{"hangup"};
+
+}  // namespace symbols
+
+} // namespace call_flow_processor::models
+
+template <>
+struct std::hash<call_flow_processor::models::Symbol> {
+    std::size_t operator()(const call_flow_processor::models::Symbol& symbol) const noexcept {
+        if (!symbol.Interned()) return std::hash<std::string_view>{}(symbol.View());
+        return symbol.Id();
+    }
+};
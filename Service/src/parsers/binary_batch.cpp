@@ -0,0 +1,258 @@
+#include "binary_batch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <type_traits>
+
+namespace call_flow_processor::parsers {
+
+namespace {
+
+using userver::storages::postgres::TimePointTz;
+
+constexpr std::string_view kMagic = "CFB";
+constexpr std::uint8_t kVersion = 2;
+constexpr std::uint8_t kFlagHasMore = 1;
+
+template <class T> struct SchemaOf;
+template <> struct SchemaOf<models::Call> { static constexpr auto kValue = BatchSchema::kCall; };
+template <> struct SchemaOf<models::Connection> { static constexpr auto kValue = BatchSchema::kConnection; };
+template <> struct SchemaOf<models::CallEvent> { static constexpr auto kValue = BatchSchema::kCallEvent; };
+template <> struct SchemaOf<models::Operator> { static constexpr auto kValue = BatchSchema::kOperator; };
+template <> struct SchemaOf<models::ExternalCDR> { static constexpr auto kValue = BatchSchema::kExternalCDR; };
+
+class Writer {
+public:
+    explicit Writer(std::string& out) : out_(out) {}
+
+    void VarUint(std::uint64_t value) {
+        while (value >= 0x80) {
+            out_.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out_.push_back(static_cast<char>(value));
+    }
+
+    void Int64(std::int64_t value) {
+        VarUint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+
+    void Int(int value) { Int64(value); }
+
+    void String(std::string_view value) {
+        VarUint(value.size());
+        out_.append(value);
+    }
+
+    void String(const models::Symbol& value) { String(value.View()); }
+
+    void Time(const TimePointTz& value) {
+        Int64(std::chrono::duration_cast<std::chrono::microseconds>(
+            value.GetUnderlying().time_since_epoch()).count());
+    }
+
+    void OptionalTime(const std::optional<TimePointTz>& value) {
+        out_.push_back(value ? 1 : 0);
+        if (value) Time(*value);
+    }
+
+    void OptionalString(const std::optional<std::string>& value) {
+        out_.push_back(value ? 1 : 0);
+        if (value) String(*value);
+    }
+
+private:
+    std::string& out_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view in) : in_(in) {}
+
+    bool AtEnd() const { return pos_ == in_.size(); }
+
+    std::uint64_t VarUint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const auto byte = static_cast<std::uint8_t>(Byte());
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw BinaryBatchError("varint is too long");
+    }
+
+    std::uint8_t Byte() {
+        if (pos_ >= in_.size()) throw BinaryBatchError("unexpected end of batch");
+        return static_cast<std::uint8_t>(in_[pos_++]);
+    }
+
+    std::string_view Bytes(std::size_t size) {
+        if (size > in_.size() - pos_) throw BinaryBatchError("unexpected end of batch");
+        const auto bytes = in_.substr(pos_, size);
+        pos_ += size;
+        return bytes;
+    }
+
+    void Int64(std::int64_t& value) {
+        const auto raw = VarUint();
+        value = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+    }
+
+    void Int(int& value) {
+        std::int64_t wide = 0;
+        Int64(wide);
+        value = static_cast<int>(wide);
+    }
+
+    void String(std::string& value) { value = Bytes(VarUint()); }
+
+    void String(models::Symbol& value) { value = models::Symbol{Bytes(VarUint())}; }
+
+    void Time(TimePointTz& value) {
+        std::int64_t micros = 0;
+        Int64(micros);
+        value = TimePointTz{std::chrono::system_clock::time_point{std::chrono::microseconds{micros}}};
+    }
+
+    void OptionalTime(std::optional<TimePointTz>& value) {
+        if (!Byte()) {
+            value.reset();
+            return;
+        }
+        Time(value.emplace());
+    }
+
+    void OptionalString(std::optional<std::string>& value) {
+        if (!Byte()) {
+            value.reset();
+            return;
+        }
+        String(value.emplace());
+    }
+
+private:
+    std::string_view in_;
+    std::size_t pos_{0};
+};
+
+// The schema of every model, shared by the encoder and the decoder. Row is
+// const for Writer and mutable for Reader. Fields may only be appended.
+template <class Io, class Row>
+void Fields(Io& io, Row& row) {
+    using T = std::remove_const_t<Row>;
+    if constexpr (std::is_same_v<T, models::Call>) {
+        io.Int64(row.id);
+        io.String(row.status);
+        io.Time(row.started_at);
+        io.Int64(row.user_id);
+        io.OptionalTime(row.finished_at);
+        io.String(row.caller_number);
+        io.String(row.callee_number);
+    } else if constexpr (std::is_same_v<T, models::Connection>) {
+        io.Int64(row.connection_id);
+        io.Int64(row.call_id);
+        io.String(row.phone);
+        io.Time(row.initiated_at);
+        io.OptionalTime(row.answered_at);
+        io.OptionalTime(row.finished_at);
+    } else if constexpr (std::is_same_v<T, models::CallEvent>) {
+        io.Int64(row.event_id);
+        io.Int64(row.call_id);
+        io.String(row.event_type);
+        io.String(row.payload);
+    } else if constexpr (std::is_same_v<T, models::Operator>) {
+        io.Int64(row.operator_id);
+        io.String(row.name);
+        io.String(row.extension);
+        io.String(row.email);
+    } else {
+        static_assert(std::is_same_v<T, models::ExternalCDR>);
+        io.String(row.call_id);
+        io.Time(row.call_start);
+        io.Time(row.call_end);
+        io.String(row.caller_number);
+        io.OptionalString(row.operator_id);
+        io.OptionalString(row.operator_name);
+        io.String(row.agent_status);
+        io.Int(row.wait_sec);
+        io.Int(row.talk_sec);
+        io.String(row.end_reason);
+    }
+}
+
+}  // namespace
+
+bool IsBinaryBatch(std::string_view content_type) {
+    const auto params = content_type.find(';');
+    auto media_type = content_type.substr(0, params);
+    while (!media_type.empty() && media_type.back() == ' ') media_type.remove_suffix(1);
+    while (!media_type.empty() && media_type.front() == ' ') media_type.remove_prefix(1);
+    return media_type == kBinaryBatchContentType;
+}
+
+template <class T>
+std::string EncodeBatch(const std::vector<T>& items, bool has_more) {
+    std::string out;
+    Writer writer(out);
+    out.append(kMagic);
+    out.push_back(static_cast<char>(kVersion));
+    out.push_back(static_cast<char>(SchemaOf<T>::kValue));
+    out.push_back(static_cast<char>(has_more ? kFlagHasMore : 0));
+    writer.VarUint(items.size());
+
+    std::string row;
+    Writer row_writer(row);
+    for (const auto& item : items) {
+        row.clear();
+        Fields(row_writer, item);
+        writer.String(row);
+    }
+    return out;
+}
+
+template <class T>
+PageInfo DecodeBatch(std::string_view body, std::vector<T>& items, std::size_t max_rows) {
+    Reader reader(body);
+    if (reader.Bytes(kMagic.size()) != kMagic) throw BinaryBatchError("not a binary batch");
+    if (const auto version = reader.Byte(); version != kVersion) {
+        throw BinaryBatchError("unsupported batch version " + std::to_string(version));
+    }
+    if (const auto schema = reader.Byte(); schema != static_cast<std::uint8_t>(SchemaOf<T>::kValue)) {
+        throw BinaryBatchError("batch schema " + std::to_string(schema) + " does not match the model");
+    }
+    const auto flags = reader.Byte();
+
+    PageInfo info;
+    info.has_next_cursor = flags & kFlagHasMore;
+    info.item_count = reader.VarUint();
+    if (info.item_count > max_rows) {
+        throw TooManyRowsError("batch has " + std::to_string(info.item_count) + " rows, at most " +
+                               std::to_string(max_rows) + " are accepted");
+    }
+    // Every row takes at least its length byte, which bounds the reservation
+    // for a corrupt row count.
+    items.reserve(items.size() + std::min<std::size_t>(info.item_count, body.size()));
+    for (std::size_t i = 0; i < info.item_count; ++i) {
+        Reader row_reader(reader.Bytes(reader.VarUint()));
+        T item{};
+        Fields(row_reader, item);
+        items.push_back(std::move(item));
+    }
+    if (!reader.AtEnd()) throw BinaryBatchError("trailing data after the last row");
+    return info;
+}
+
+template std::string EncodeBatch(const std::vector<models::Call>&, bool);
+template std::string EncodeBatch(const std::vector<models::CallEvent>&, bool);
+template std::string EncodeBatch(const std::vector<models::Connection>&, bool);
+template std::string EncodeBatch(const std::vector<models::Operator>&, bool);
+template std::string EncodeBatch(const std::vector<models::ExternalCDR>&, bool);
+
+template PageInfo DecodeBatch(std::string_view, std::vector<models::Call>&, std::size_t);
+template PageInfo DecodeBatch(std::string_view, std::vector<models::CallEvent>&, std::size_t);
+template PageInfo DecodeBatch(std::string_view, std::vector<models::Connection>&, std::size_t);
+template PageInfo DecodeBatch(std::string_view, std::vector<models::Operator>&, std::size_t);
+template PageInfo DecodeBatch(std::string_view, std::vector<models::ExternalCDR>&, std::size_t);
+
+}  // namespace call_flow_processor::parsers
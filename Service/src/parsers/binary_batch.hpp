@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "models/call.hpp"
+#include "models/call_event.hpp"
+#include "models/connection.hpp"
+#include "models/external_cdr.hpp"
+#include "models/operator.hpp"
+#include "page_parser.hpp"
+
+namespace call_flow_processor::parsers {
+
+// Compact alternative to the JSON pages and upload bodies, negotiated with
+// Content-Type / Accept:
+//
+//   batch := "CFB" version:u8 schema:u8 flags:u8 row_count:varint row*
+//   row   := length:varint field*
+//
+// Fields are written in schema order without names: integers as zigzag
+// varints, strings as varint length + bytes, timestamps as microseconds
+// since the epoch, optionals as a 0/1 presence byte followed by the value.
+// Readers ignore bytes left in a row after the fields they know. Adding a
+// field that readers require bumps the version, so batches of older
+// producers are rejected rather than misread; version 2 added finished_at,
+// caller_number and callee_number to calls. Flag bit 0 marks a source page
+// that has more rows after it, as a non-null next_cursor does in JSON.
+inline constexpr std::string_view kBinaryBatchContentType = "application/x-cfp-batch";
+inline constexpr std::string_view kJsonContentType = "application/json";
+// Accept header for sources: binary batches preferred, JSON understood.
+inline constexpr std::string_view kBatchAccept = "application/x-cfp-batch, application/json;q=0.5";
+
+enum class BatchSchema : std::uint8_t {
+    kCall = 1,
+    kConnection = 2,
+    kCallEvent = 3,
+    kOperator = 4,
+    kExternalCDR = 5,
+};
+
+class BinaryBatchError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// True if the media type of a Content-Type header value is the binary batch
+// one; parameters are ignored.
+bool IsBinaryBatch(std::string_view content_type);
+
+template <class T>
+std::string EncodeBatch(const std::vector<T>& items, bool has_more = false);
+
+// Appends the rows of a binary batch to items. Any malformed row fails the
+// whole batch with BinaryBatchError: unlike JSON pages, batches are produced
+// by programs and a bad one means a broken producer. A row count above
+// max_rows in the header throws TooManyRowsError before any row is decoded.
+template <class T>
+PageInfo DecodeBatch(std::string_view body, std::vector<T>& items, std::size_t max_rows = kUnlimitedRows);
+
+// Decodes a page or pushed batch in whichever format its Content-Type names.
+template <class T>
+PageInfo DecodePage(std::string_view content_type, std::string_view body, std::vector<T>& items,
+                    std::size_t max_rows = kUnlimitedRows) {
+    if (IsBinaryBatch(content_type)) return DecodeBatch(body, items, max_rows);
+    return ParsePage(body, items, max_rows);
+}
+
+extern template std::string EncodeBatch(const std::vector<models::Call>&, bool);
+extern template std::string EncodeBatch(const std::vector<models::CallEvent>&, bool);
+extern template std::string EncodeBatch(const std::vector<models::Connection>&, bool);
+extern template std::string EncodeBatch(const std::vector<models::Operator>&, bool);
+extern template std::string EncodeBatch(const std::vector<models::ExternalCDR>&, bool);
+
+extern template PageInfo DecodeBatch(std::string_view, std::vector<models::Call>&, std::size_t);
+extern template PageInfo DecodeBatch(std::string_view, std::vector<models::CallEvent>&, std::size_t);
+extern template PageInfo DecodeBatch(std::string_view, std::vector<models::Connection>&, std::size_t);
+extern template PageInfo DecodeBatch(std::string_view, std::vector<models::Operator>&, std::size_t);
+extern template PageInfo DecodeBatch(std::string_view, std::vector<models::ExternalCDR>&, std::size_t);
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,373 @@
+#include "json_reader.hpp"
+
+#include <limits>
+
+namespace call_flow_processor::parsers {
+
+namespace {
+
+bool IsWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+void AppendUtf8(std::string& out, std::uint32_t code_point) {
+    if (code_point < 0x80) {
+        out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+}  // namespace
+
+JsonParseError::JsonParseError(const std::string& what, std::size_t position)
+    : std::runtime_error(what + " at offset " + std::to_string(position)),
+      position_(position) {}
+
+JsonReader::JsonReader(std::string_view input) : input_(input) {}
+
+JsonReader::Type JsonReader::Peek() {
+    SkipWhitespace();
+    switch (Current()) {
+        case 'n': return Type::kNull;
+        case 't':
+        case 'f': return Type::kBool;
+        case '"': return Type::kString;
+        case '[': return Type::kArray;
+        case '{': return Type::kObject;
+        default:
+            if (IsNumberChar(Current())) return Type::kNumber;
+            Fail("Unexpected character");
+    }
+}
+
+void JsonReader::BeginObject() {
+    SkipWhitespace();
+    Expect('{');
+    first_.push_back(true);
+}
+
+bool JsonReader::NextKey(std::string_view& key) {
+    if (first_.empty()) Fail("NextKey() outside of an object");
+    SkipWhitespace();
+    if (Current() == '}') {
+        ++pos_;
+        first_.pop_back();
+        return false;
+    }
+    if (!first_.back()) {
+        Expect(',');
+        SkipWhitespace();
+    }
+    first_.back() = false;
+    key = ReadKey();
+    SkipWhitespace();
+    Expect(':');
+    return true;
+}
+
+void JsonReader::BeginArray() {
+    SkipWhitespace();
+    Expect('[');
+    first_.push_back(true);
+}
+
+bool JsonReader::NextElement() {
+    if (first_.empty()) Fail("NextElement() outside of an array");
+    SkipWhitespace();
+    if (Current() == ']') {
+        ++pos_;
+        first_.pop_back();
+        return false;
+    }
+    if (!first_.back()) Expect(',');
+    first_.back() = false;
+    return true;
+}
+
+std::int64_t JsonReader::ReadInt64() {
+    SkipWhitespace();
+    const bool negative = Current() == '-';
+    if (negative) ++pos_;
+    if (pos_ >= input_.size() || input_[pos_] < '0' || input_[pos_] > '9') Fail("Expected integer");
+
+    // Accumulate as a negative number so that INT64_MIN fits.
+    std::int64_t value = 0;
+    constexpr auto kMin = std::numeric_limits<std::int64_t>::min();
+    while (pos_ < input_.size() && input_[pos_] >= '0' && input_[pos_] <= '9') {
+        const int digit = input_[pos_] - '0';
+        if (value < (kMin + digit) / 10) Fail("Integer overflow");
+        value = value * 10 - digit;
+        ++pos_;
+    }
+    if (pos_ < input_.size() && (input_[pos_] == '.' || input_[pos_] == 'e' || input_[pos_] == 'E')) {
+        Fail("Expected integer, got fractional number");
+    }
+    if (!negative) {
+        if (value == kMin) Fail("Integer overflow");
+        value = -value;
+    }
+    return value;
+}
+
+bool JsonReader::ReadBool() {
+    SkipWhitespace();
+    if (Current() == 't') {
+        ExpectLiteral("true");
+        return true;
+    }
+    ExpectLiteral("false");
+    return false;
+}
+
+std::string JsonReader::ReadString() {
+    SkipWhitespace();
+    Expect('"');
+    std::string result;
+    std::size_t chunk_begin = pos_;
+    while (true) {
+        const char c = Current();
+        if (c == '"') {
+            result.append(input_.data() + chunk_begin, pos_ - chunk_begin);
+            ++pos_;
+            return result;
+        }
+        if (c == '\\') {
+            result.append(input_.data() + chunk_begin, pos_ - chunk_begin);
+            ++pos_;
+            AppendUtf8(result, ReadEscape());
+            chunk_begin = pos_;
+            continue;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) Fail("Control character in string");
+        ++pos_;
+    }
+}
+
+std::string_view JsonReader::ReadString(std::string& scratch) {
+    SkipWhitespace();
+    const auto begin = pos_ + 1;
+    Expect('"');
+    while (true) {
+        const char c = Current();
+        if (c == '"') {
+            ++pos_;
+            return input_.substr(begin, pos_ - 1 - begin);
+        }
+        if (c == '\\') {
+            pos_ = begin - 1;
+            scratch = ReadString();
+            return scratch;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) Fail("Control character in string");
+        ++pos_;
+    }
+}
+
+bool JsonReader::TryReadNull() {
+    SkipWhitespace();
+    if (Current() != 'n') return false;
+    ExpectLiteral("null");
+    return true;
+}
+
+std::string_view JsonReader::ReadRawValue() {
+    SkipWhitespace();
+    const auto begin = pos_;
+    SkipValue();
+    return input_.substr(begin, pos_ - begin);
+}
+
+void JsonReader::SkipValue() {
+    // Iterative, so deeply nested input can't exhaust the stack. `open` holds
+    // the closing bracket of every container entered so far.
+    std::string open;
+    while (true) {
+        SkipWhitespace();
+        switch (Current()) {
+            case '{':
+                BeginObject();
+                open.push_back('}');
+                break;
+            case '[':
+                BeginArray();
+                open.push_back(']');
+                break;
+            case '"':
+                SkipString();
+                break;
+            case 't':
+                ExpectLiteral("true");
+                break;
+            case 'f':
+                ExpectLiteral("false");
+                break;
+            case 'n':
+                ExpectLiteral("null");
+                break;
+            default:
+                if (Current() != '-' && !IsDigit(Current())) Fail("Unexpected character");
+                SkipNumber();
+        }
+        // Close the containers that are done until another value is due.
+        while (!open.empty()) {
+            std::string_view key;
+            if (open.back() == '}' ? NextKey(key) : NextElement()) break;
+            open.pop_back();
+        }
+        if (open.empty()) return;
+    }
+}
+
+void JsonReader::SkipUnchecked() {
+    SkipWhitespace();
+    std::size_t depth = 0;
+    while (true) {
+        const char c = Current();
+        if (depth == 0 && (c == ',' || c == ']' || c == '}')) return;
+        ++pos_;
+        if (c == '"') {
+            // Only the end of a string matters here, escapes are stepped over.
+            while (Current() != '"') pos_ += input_[pos_] == '\\' ? 2 : 1;
+            ++pos_;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            return;
+        }
+    }
+}
+
+void JsonReader::ExpectEnd() {
+    SkipWhitespace();
+    if (pos_ != input_.size()) Fail("Trailing data after JSON value");
+}
+
+void JsonReader::Rewind(std::size_t position, std::size_t depth) {
+    pos_ = position;
+    first_.resize(depth);
+}
+
+void JsonReader::SkipWhitespace() {
+    while (pos_ < input_.size() && IsWhitespace(input_[pos_])) ++pos_;
+}
+
+char JsonReader::Current() {
+    if (pos_ >= input_.size()) Fail("Unexpected end of input");
+    return input_[pos_];
+}
+
+void JsonReader::Expect(char c) {
+    if (Current() != c) Fail(std::string("Expected '") + c + "'");
+    ++pos_;
+}
+
+void JsonReader::ExpectLiteral(std::string_view literal) {
+    if (input_.substr(pos_, literal.size()) != literal) {
+        Fail("Expected '" + std::string(literal) + "'");
+    }
+    pos_ += literal.size();
+}
+
+// Keys are returned as raw slices; escape sequences in keys are validated
+// but not decoded.
+std::string_view JsonReader::ReadKey() {
+    const auto begin = pos_ + 1;
+    SkipString();
+    return input_.substr(begin, pos_ - 1 - begin);
+}
+
+void JsonReader::SkipString() {
+    Expect('"');
+    while (true) {
+        const char c = Current();
+        if (c == '"') break;
+        if (static_cast<unsigned char>(c) < 0x20) Fail("Control character in string");
+        ++pos_;
+        if (c == '\\') ReadEscape();
+    }
+    ++pos_;
+}
+
+void JsonReader::SkipNumber() {
+    if (Current() == '-') ++pos_;
+    if (Current() == '0') {
+        ++pos_;
+    } else {
+        SkipDigits();
+    }
+    if (pos_ < input_.size() && input_[pos_] == '.') {
+        ++pos_;
+        SkipDigits();
+    }
+    if (pos_ < input_.size() && (input_[pos_] == 'e' || input_[pos_] == 'E')) {
+        ++pos_;
+        if (Current() == '+' || Current() == '-') ++pos_;
+        SkipDigits();
+    }
+}
+
+void JsonReader::SkipDigits() {
+    if (!IsDigit(Current())) Fail("Expected digit");
+    while (pos_ < input_.size() && IsDigit(input_[pos_])) ++pos_;
+}
+
+std::uint32_t JsonReader::ReadEscape() {
+    const char c = Current();
+    ++pos_;
+    switch (c) {
+        case '"': return '"';
+        case '\\': return '\\';
+        case '/': return '/';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        case 'u': break;
+        default: Fail("Invalid escape sequence");
+    }
+
+    std::uint32_t code_point = ReadHex4();
+    if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+        ExpectLiteral("\\u");
+        const auto low = ReadHex4();
+        if (low < 0xDC00 || low > 0xDFFF) Fail("Invalid surrogate pair");
+        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    } else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+        Fail("Unpaired low surrogate");
+    }
+    return code_point;
+}
+
+std::uint32_t JsonReader::ReadHex4() {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = Current();
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else Fail("Invalid \\u escape");
+        ++pos_;
+    }
+    return value;
+}
+
+void JsonReader::Fail(const std::string& what) const { throw JsonParseError(what, pos_); }
+
+}  // namespace call_flow_processor::parsers
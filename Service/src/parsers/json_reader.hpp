@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace call_flow_processor::parsers {
+
+class JsonParseError : public std::runtime_error {
+public:
+    JsonParseError(const std::string& what, std::size_t position);
+
+    std::size_t Position() const { return position_; }
+
+private:
+    std::size_t position_;
+};
+
+// Forward-only pull reader over a JSON document. Values are consumed in
+// document order straight from the input buffer, no DOM is built.
+//
+//   JsonReader reader(body);
+//   reader.BeginArray();
+//   while (reader.NextElement()) {
+//       reader.BeginObject();
+//       std::string_view key;
+//       while (reader.NextKey(key)) {
+//           if (key == "id") id = reader.ReadInt64();
+//           else reader.SkipValue();
+//       }
+//   }
+//   reader.ExpectEnd();
+class JsonReader {
+public:
+    enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+    explicit JsonReader(std::string_view input);
+
+    Type Peek();
+
+    void BeginObject();
+    // Moves to the next member of the innermost object. Returns false and
+    // consumes the closing brace once there are no members left.
+    bool NextKey(std::string_view& key);
+
+    void BeginArray();
+    // Moves to the next element of the innermost array. Returns false and
+    // consumes the closing bracket once there are no elements left.
+    bool NextElement();
+
+    std::int64_t ReadInt64();
+    bool ReadBool();
+    std::string ReadString();
+    // Same as ReadString() without the copy: the view points into the input,
+    // or into scratch when the string has escapes to decode.
+    std::string_view ReadString(std::string& scratch);
+    // Consumes a null literal if it is next, leaves the input untouched otherwise.
+    bool TryReadNull();
+    // Returns the unparsed text of the next value and skips it. The value is
+    // validated like SkipValue() does, so the text is well-formed JSON.
+    std::string_view ReadRawValue();
+    // Skips the next value, checking its syntax all the way down.
+    void SkipValue();
+    // Skips the next value by bracket counting without validating it, to
+    // resynchronize on the end of a value that failed to parse.
+    void SkipUnchecked();
+
+    void ExpectEnd();
+
+    // Allow the caller to resynchronize after rejecting a value it started
+    // reading; Rewind() is only valid at the same nesting depth.
+    std::size_t Position() const { return pos_; }
+    std::size_t Depth() const { return first_.size(); }
+    void Rewind(std::size_t position, std::size_t depth);
+
+private:
+    void SkipWhitespace();
+    char Current();
+    void Expect(char c);
+    void ExpectLiteral(std::string_view literal);
+    std::string_view ReadKey();
+    void SkipString();
+    void SkipNumber();
+    void SkipDigits();
+    // Consumes an escape sequence after its backslash, returns the code point.
+    std::uint32_t ReadEscape();
+    std::uint32_t ReadHex4();
+    [[noreturn]] void Fail(const std::string& what) const;
+
+    std::string_view input_;
+    std::size_t pos_{0};
+    // One entry per open container: true until its first element is read.
+    std::vector<bool> first_;
+};
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,125 @@
+#include "json_writer.hpp"
+
+#include <charconv>
+
+namespace call_flow_processor::parsers {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+// True for the bytes a JSON string can not hold as they are.
+bool NeedsEscape(char c) {
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+}  // namespace
+
+void JsonWriter::BeginObject() {
+    Separator();
+    out_.push_back('{');
+    need_comma_ = false;
+}
+
+void JsonWriter::EndObject() {
+    out_.push_back('}');
+    need_comma_ = true;
+}
+
+void JsonWriter::BeginArray() {
+    Separator();
+    out_.push_back('[');
+    need_comma_ = false;
+}
+
+void JsonWriter::EndArray() {
+    out_.push_back(']');
+    need_comma_ = true;
+}
+
+void JsonWriter::Key(std::string_view key) {
+    Separator();
+    Quoted(key);
+    out_.push_back(':');
+    need_comma_ = false;
+}
+
+void JsonWriter::Int64(std::int64_t value) {
+    Separator();
+    char buffer[20];
+    const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+    out_.append(buffer, result.ptr);
+    need_comma_ = true;
+}
+
+void JsonWriter::String(std::string_view value) {
+    Separator();
+    Quoted(value);
+    need_comma_ = true;
+}
+
+void JsonWriter::Separator() {
+    if (need_comma_) out_.push_back(',');
+}
+
+void JsonWriter::Quoted(std::string_view value) {
+    out_.push_back('"');
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (!NeedsEscape(c)) continue;
+        out_.append(value.data() + begin, i - begin);
+        begin = i + 1;
+        switch (c) {
+            case '"': out_.append("\\\""); break;
+            case '\\': out_.append("\\\\"); break;
+            case '\b': out_.append("\\b"); break;
+            case '\f': out_.append("\\f"); break;
+            case '\n': out_.append("\\n"); break;
+            case '\r': out_.append("\\r"); break;
+            case '\t': out_.append("\\t"); break;
+            default: {
+                const char escape[] = {'\\', 'u', '0', '0', kHexDigits[(c >> 4) & 0xF], kHexDigits[c & 0xF]};
+                out_.append(escape, sizeof(escape));
+            }
+        }
+    }
+    out_.append(value.data() + begin, value.size() - begin);
+    out_.push_back('"');
+}
+
+void WriteJson(const std::vector<models::ExternalCDR>& items, std::string& out) {
+    JsonWriter writer(out);
+    writer.BeginArray();
+    for (const auto& cdr : items) {
+        writer.BeginObject();
+        writer.Key("call_id");
+        writer.String(cdr.call_id);
+        writer.Key("call_start");
+        writer.Int64(cdr.call_start.GetUnderlying().time_since_epoch().count());
+        writer.Key("call_end");
+        writer.Int64(cdr.call_end.GetUnderlying().time_since_epoch().count());
+        writer.Key("caller_number");
+        writer.String(cdr.caller_number);
+        if (cdr.operator_id) {
+            writer.Key("operator_id");
+            writer.String(*cdr.operator_id);
+        }
+        if (cdr.operator_name) {
+            writer.Key("operator_name");
+            writer.String(*cdr.operator_name);
+        }
+        writer.Key("agent_status");
+        writer.String(cdr.agent_status);
+        writer.Key("wait_sec");
+        writer.Int64(cdr.wait_sec);
+        writer.Key("talk_sec");
+        writer.Int64(cdr.talk_sec);
+        writer.Key("end_reason");
+        writer.String(cdr.end_reason);
+        writer.EndObject();
+    }
+    writer.EndArray();
+}
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "models/external_cdr.hpp"
+
+namespace call_flow_processor::parsers {
+
+// Append-only JSON writer, the counterpart of JsonReader: values go
+// straight into the caller's buffer, no DOM is built. The caller is
+// responsible for a well-formed sequence of calls, nothing is checked.
+//
+//   std::string out;
+//   JsonWriter writer(out);
+//   writer.BeginObject();
+//   writer.Key("id");
+//   writer.Int64(id);
+//   writer.EndObject();
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    void Key(std::string_view key);
+
+    void Int64(std::int64_t value);
+    void String(std::string_view value);
+
+private:
+    void Separator();
+    void Quoted(std::string_view value);
+
+    std::string& out_;
+    // Set after a value, so the next key or element is preceded by a comma.
+    bool need_comma_{false};
+};
+
+// Appends the upload body of ExternalCDRUploader: a JSON array with one
+// object per CDR. out is not cleared, so a buffer can be reused across
+// batches.
+void WriteJson(const std::vector<models::ExternalCDR>& items, std::string& out);
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include <userver/formats/json.hpp>
+
+#include "json_writer.hpp"
+
+#include "benchmarks/allocations.hpp"
+
+#include <string>
+#include <vector>
+
+namespace call_flow_processor::parsers {
+
+namespace {
+
+std::vector<models::ExternalCDR> MakeExternalCDRs(std::size_t rows) {
+    std::vector<models::ExternalCDR> result;
+    for (std::size_t i = 0; i < rows; ++i) {
+        models::ExternalCDR cdr{};
+        cdr.call_id = std::to_string(100000 + i);
+        cdr.caller_number = "+19998887766";
+        if (i % 4) {
+            cdr.operator_id = std::to_string(i % 50);
+            cdr.operator_name = "Alice \"Al\" Cooper";
+        }
+        cdr.agent_status = i % 4 ? "ANSWERED" : "NO_ANSWER";
+        cdr.wait_sec = static_cast<int>(i % 60);
+        cdr.talk_sec = static_cast<int>(i % 600);
+        cdr.end_reason = "COMPLETED";
+        result.push_back(std::move(cdr));
+    }
+    return result;
+}
+
+// The body ExternalCDRUploader built before WriteJson(): a DOM per CDR,
+// pushed into an array DOM, serialized at the end.
+std::string ToJsonDom(const std::vector<models::ExternalCDR>& data) {
+    userver::formats::json::ValueBuilder arr;
+    for (const auto& cdr : data) {
+        userver::formats::json::ValueBuilder ob;
+        ob["call_id"] = cdr.call_id;
+        ob["call_start"] = userver::formats::json::ValueBuilder(cdr.call_start.GetUnderlying().time_since_epoch().count());
+        ob["call_end"] = userver::formats::json::ValueBuilder(cdr.call_end.GetUnderlying().time_since_epoch().count());
+        ob["caller_number"] = cdr.caller_number;
+        if (cdr.operator_id) ob["operator_id"] = cdr.operator_id.value();
+        if (cdr.operator_name) ob["operator_name"] = cdr.operator_name.value();
+        ob["agent_status"] = cdr.agent_status;
+        ob["wait_sec"] = cdr.wait_sec;
+        ob["talk_sec"] = cdr.talk_sec;
+        ob["end_reason"] = cdr.end_reason;
+        arr.PushBack(ob.ExtractValue());
+    }
+    return userver::formats::json::ToString(arr.ExtractValue());
+}
+
+void SetCounters(benchmark::State& state, std::size_t body_bytes, std::size_t allocations) {
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * body_bytes);
+    state.counters["body_bytes"] = body_bytes;
+    state.counters["allocs_per_cdr"] = static_cast<double>(allocations) / (state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+void ExternalCDRsJsonDom(benchmark::State& state) {
+    const auto cdrs = MakeExternalCDRs(state.range(0));
+    const auto body_bytes = ToJsonDom(cdrs).size();
+    const auto before = benchmarks::AllocationCount();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ToJsonDom(cdrs));
+    }
+    SetCounters(state, body_bytes, benchmarks::AllocationCount() - before);
+}
+BENCHMARK(ExternalCDRsJsonDom)->RangeMultiplier(10)->Range(10, 1000);
+
+// The buffer is reused across iterations, as a long-lived writer would.
+void ExternalCDRsJsonWriter(benchmark::State& state) {
+    const auto cdrs = MakeExternalCDRs(state.range(0));
+    std::string body;
+    WriteJson(cdrs, body);
+    const auto body_bytes = body.size();
+    const auto before = benchmarks::AllocationCount();
+    for (auto _ : state) {
+        body.clear();
+        WriteJson(cdrs, body);
+        benchmark::DoNotOptimize(body);
+    }
+    SetCounters(state, body_bytes, benchmarks::AllocationCount() - before);
+}
+BENCHMARK(ExternalCDRsJsonWriter)->RangeMultiplier(10)->Range(10, 1000);
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,216 @@
+#include "page_parser.hpp"
+#include "json_reader.hpp"
+
+#include <userver/logging/log.hpp>
+#include <userver/utils/datetime.hpp>
+
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+namespace call_flow_processor::parsers {
+
+namespace {
+
+using userver::storages::postgres::TimePointTz;
+
+class RowError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+TimePointTz ReadTimePoint(JsonReader& reader) {
+    return TimePointTz{userver::utils::datetime::Stringtime(
+        reader.ReadString(), "UTC", userver::utils::datetime::kRfc3339Format)};
+}
+
+// Known values are interned without allocating.
+models::Symbol ReadSymbol(JsonReader& reader) {
+    std::string scratch;
+    return models::Symbol{reader.ReadString(scratch)};
+}
+
+std::optional<TimePointTz> ReadOptionalTimePoint(JsonReader& reader) {
+    if (reader.TryReadNull()) return std::nullopt;
+    return ReadTimePoint(reader);
+}
+
+// Every ParseRow() sets bit i of `seen` once it reads required field i.
+template <std::size_t N>
+void CheckRequired(unsigned seen, const std::array<std::string_view, N>& names) {
+    for (std::size_t i = 0; i < N; ++i) {
+        if (!(seen & (1u << i))) throw RowError("missing field '" + std::string(names[i]) + "'");
+    }
+}
+
+void ParseRow(JsonReader& reader, models::Call& call) {
+    static constexpr std::array<std::string_view, 6> kRequired{
+        "id", "status", "started_at", "user_id", "caller_number", "callee_number"};
+    unsigned seen = 0;
+    reader.BeginObject();
+    std::string_view key;
+    while (reader.NextKey(key)) {
+        if (key == "id") {
+            call.id = reader.ReadInt64();
+            seen |= 1u << 0;
+        } else if (key == "status") {
+            call.status = ReadSymbol(reader);
+            seen |= 1u << 1;
+        } else if (key == "started_at") {
+            call.started_at = ReadTimePoint(reader);
+            seen |= 1u << 2;
+        } else if (key == "user_id") {
+            call.user_id = reader.ReadInt64();
+            seen |= 1u << 3;
+        } else if (key == "finished_at") {
+            call.finished_at = ReadOptionalTimePoint(reader);
+        } else if (key == "caller_number") {
+            call.caller_number = reader.ReadString();
+            seen |= 1u << 4;
+        } else if (key == "callee_number") {
+            call.callee_number = reader.ReadString();
+            seen |= 1u << 5;
+        } else {
+            reader.SkipValue();
+        }
+    }
+    CheckRequired(seen, kRequired);
+}
+
+void ParseRow(JsonReader& reader, models::CallEvent& event) {
+    static constexpr std::array<std::string_view, 4> kRequired{"event_id", "call_id", "event_type", "payload"};
+    unsigned seen = 0;
+    reader.BeginObject();
+    std::string_view key;
+    while (reader.NextKey(key)) {
+        if (key == "event_id") {
+            event.event_id = reader.ReadInt64();
+            seen |= 1u << 0;
+        } else if (key == "call_id") {
+            event.call_id = reader.ReadInt64();
+            seen |= 1u << 1;
+        } else if (key == "event_type") {
+            event.event_type = ReadSymbol(reader);
+            seen |= 1u << 2;
+        } else if (key == "payload") {
+            event.payload = reader.ReadRawValue();
+            seen |= 1u << 3;
+        } else {
+            reader.SkipValue();
+        }
+    }
+    CheckRequired(seen, kRequired);
+}
+
+void ParseRow(JsonReader& reader, models::Connection& conn) {
+    static constexpr std::array<std::string_view, 4> kRequired{"connection_id", "call_id", "phone", "initiated_at"};
+    unsigned seen = 0;
+    reader.BeginObject();
+    std::string_view key;
+    while (reader.NextKey(key)) {
+        if (key == "connection_id") {
+            conn.connection_id = reader.ReadInt64();
+            seen |= 1u << 0;
+        } else if (key == "call_id") {
+            conn.call_id = reader.ReadInt64();
+            seen |= 1u << 1;
+        } else if (key == "phone") {
+            conn.phone = reader.ReadString();
+            seen |= 1u << 2;
+        } else if (key == "initiated_at") {
+            conn.initiated_at = ReadTimePoint(reader);
+            seen |= 1u << 3;
+        } else if (key == "answered_at") {
+            conn.answered_at = ReadOptionalTimePoint(reader);
+        } else if (key == "finished_at") {
+            conn.finished_at = ReadOptionalTimePoint(reader);
+        } else {
+            reader.SkipValue();
+        }
+    }
+    CheckRequired(seen, kRequired);
+}
+
+void ParseRow(JsonReader& reader, models::Operator& op) {
+    static constexpr std::array<std::string_view, 4> kRequired{"operator_id", "name", "extension", "email"};
+    unsigned seen = 0;
+    reader.BeginObject();
+    std::string_view key;
+    while (reader.NextKey(key)) {
+        if (key == "operator_id") {
+            op.operator_id = reader.ReadInt64();
+            seen |= 1u << 0;
+        } else if (key == "name") {
+            op.name = reader.ReadString();
+            seen |= 1u << 1;
+        } else if (key == "extension") {
+            op.extension = reader.ReadString();
+            seen |= 1u << 2;
+        } else if (key == "email") {
+            op.email = reader.ReadString();
+            seen |= 1u << 3;
+        } else {
+            reader.SkipValue();
+        }
+    }
+    CheckRequired(seen, kRequired);
+}
+
+template <class T>
+void ParseRows(JsonReader& reader, std::vector<T>& items, PageInfo& info, std::size_t max_rows) {
+    reader.BeginArray();
+    while (reader.NextElement()) {
+        if (++info.item_count > max_rows) {
+            throw TooManyRowsError("batch has more than " + std::to_string(max_rows) + " rows");
+        }
+        const auto row_position = reader.Position();
+        const auto row_depth = reader.Depth();
+        try {
+            T item{};
+            ParseRow(reader, item);
+            items.push_back(std::move(item));
+        } catch (const std::exception& ex) {
+            // A missing or mistyped field, or a syntax error inside the row
+            // such as a malformed payload: drop the row and resynchronize on
+            // its end. Only unbalanced brackets fail the whole page.
+            reader.Rewind(row_position, row_depth);
+            reader.SkipUnchecked();
+            ++info.rejected_count;
+            LOG_ERROR() << "Failed to parse row: " << ex.what();
+        }
+    }
+}
+
+}  // namespace
+
+template <class T>
+PageInfo ParsePage(std::string_view body, std::vector<T>& items, std::size_t max_rows) {
+    PageInfo info;
+    JsonReader reader(body);
+
+    if (reader.Peek() == JsonReader::Type::kArray) {
+        ParseRows(reader, items, info, max_rows);
+    } else {
+        reader.BeginObject();
+        std::string_view key;
+        while (reader.NextKey(key)) {
+            if (key == "results") {
+                ParseRows(reader, items, info, max_rows);
+            } else if (key == "next_cursor") {
+                info.has_next_cursor = !reader.TryReadNull();
+                if (info.has_next_cursor) reader.SkipValue();
+            } else {
+                reader.SkipValue();
+            }
+        }
+    }
+    reader.ExpectEnd();
+    return info;
+}
+
+template PageInfo ParsePage(std::string_view, std::vector<models::Call>&, std::size_t);
+template PageInfo ParsePage(std::string_view, std::vector<models::CallEvent>&, std::size_t);
+template PageInfo ParsePage(std::string_view, std::vector<models::Connection>&, std::size_t);
+template PageInfo ParsePage(std::string_view, std::vector<models::Operator>&, std::size_t);
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "models/call.hpp"
+#include "models/call_event.hpp"
+#include "models/connection.hpp"
+#include "models/operator.hpp"
+
+namespace call_flow_processor::parsers {
+
+struct PageInfo {
+    // Rows present in the page, including the rejected ones.
+    std::size_t item_count{0};
+    std::size_t rejected_count{0};
+    bool has_next_cursor{false};
+};
+
+// Thrown as soon as a page turns out to hold more rows than the max_rows it
+// is decoded with, before the rest of it is parsed.
+class TooManyRowsError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+inline constexpr std::size_t kUnlimitedRows = std::numeric_limits<std::size_t>::max();
+
+// Decodes a source page straight into models without building a JSON DOM.
+// The page is either a bare array of rows or an object
+// {"results": [...], "next_cursor": <cursor|null>}. Unknown fields are
+// skipped; a row with missing or mistyped fields is logged and dropped,
+// while malformed JSON fails the whole page with JsonParseError.
+template <class T>
+PageInfo ParsePage(std::string_view body, std::vector<T>& items, std::size_t max_rows = kUnlimitedRows);
+
+extern template PageInfo ParsePage(std::string_view, std::vector<models::Call>&, std::size_t);
+extern template PageInfo ParsePage(std::string_view, std::vector<models::CallEvent>&, std::size_t);
+extern template PageInfo ParsePage(std::string_view, std::vector<models::Connection>&, std::size_t);
+extern template PageInfo ParsePage(std::string_view, std::vector<models::Operator>&, std::size_t);
+
+}  // namespace call_flow_processor::parsers
@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <userver/formats/json.hpp>
+
+#include "binary_batch.hpp"
+#include "page_parser.hpp"
+
+#include <string>
+#include <vector>
+
+namespace call_flow_processor::parsers {
+
+namespace {
+
+std::string MakeCallEventsPage(std::size_t rows) {
+    std::string page = R"({"results": [)";
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (i) page += ',';
+        page += R"({"event_id": )" + std::to_string(3000 + i) +
+                R"(, "call_id": )" + std::to_string(1000 + i / 8) +
+                R"(, "event_type": "operator_assigned", "payload": {"operator_id": )" + std::to_string(i % 50) +
+                R"(, "name": "Alice Cooper", "context": {"queue": "support", "skills": ["en", "billing"],)"
+                R"( "priority": 3, "tags": {"vip": false, "campaign": "PromoA"}}}, "source": "ivr-7"})";
+    }
+    page += R"(], "next_cursor": )" + std::to_string(3000 + rows) + "}";
+    return page;
+}
+
+// The decoding path the fetchers used before ParsePage(): build a DOM, copy
+// the fields out of it and re-serialize the payload for the INSERT.
+std::vector<models::CallEvent> ParseCallEventsDom(const std::string& body) {
+    std::vector<models::CallEvent> result;
+    const auto json = userver::formats::json::FromString(body);
+    for (const auto& item : json["results"]) {
+        models::CallEvent ev;
+        ev.event_id = item["event_id"].As<std::int64_t>();
+        ev.call_id = item["call_id"].As<std::int64_t>();
+        ev.event_type = models::Symbol{item["event_type"].As<std::string>()};
+        ev.payload = userver::formats::json::ToString(item["payload"]);
+        result.emplace_back(std::move(ev));
+    }
+    return result;
+}
+
+}  // namespace
+
+void CallEventsPageDom(benchmark::State& state) {
+    const auto page = MakeCallEventsPage(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ParseCallEventsDom(page));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * page.size());
+    state.counters["page_bytes"] = page.size();
+}
+BENCHMARK(CallEventsPageDom)->RangeMultiplier(10)->Range(10, 1000);
+
+void CallEventsPageStreaming(benchmark::State& state) {
+    const auto page = MakeCallEventsPage(state.range(0));
+    for (auto _ : state) {
+        std::vector<models::CallEvent> items;
+        items.reserve(state.range(0));
+        benchmark::DoNotOptimize(ParsePage(page, items));
+        benchmark::DoNotOptimize(items);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * page.size());
+    state.counters["page_bytes"] = page.size();
+}
+BENCHMARK(CallEventsPageStreaming)->RangeMultiplier(10)->Range(10, 1000);
+
+// The same page as a binary batch; page_bytes shows the size on the wire.
+void CallEventsPageBinary(benchmark::State& state) {
+    std::vector<models::CallEvent> rows;
+    ParsePage(MakeCallEventsPage(state.range(0)), rows);
+    const auto page = EncodeBatch(rows, true);
+    for (auto _ : state) {
+        std::vector<models::CallEvent> items;
+        items.reserve(state.range(0));
+        benchmark::DoNotOptimize(DecodeBatch(page, items));
+        benchmark::DoNotOptimize(items);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * page.size());
+    state.counters["page_bytes"] = page.size();
+}
+BENCHMARK(CallEventsPageBinary)->RangeMultiplier(10)->Range(10, 1000);
+
+}  // namespace call_flow_processor::parsers
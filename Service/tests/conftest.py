@@ -26,8 +26,30 @@ def pgsql_local(service_source_dir, pgsql_local_create):
 
 
 @pytest.fixture(scope='session')
-def prepare_service_config_resources():
+def archive_dir(tmp_path_factory):
+    """Archive directory of the call-retention component."""
+    return tmp_path_factory.mktemp('archive')
+
+
+@pytest.fixture(scope='session')
+def dump_root(tmp_path_factory):
+    """Cache dump directory of the dump-configurator component."""
+    return tmp_path_factory.mktemp('dumps')
+
+
+@pytest.fixture(scope='session')
+def prepare_service_config_resources(archive_dir, dump_root):
     def patch_config(config, config_vars):
         components = config['components_manager']['components']
+        components['call-retention']['archive-dir'] = str(archive_dir)
+        components['dump-configurator']['dump-root'] = str(dump_root)
+        # Small chunks and short timeouts, so delivery tests can exercise
+        # chunking, timeouts and retries quickly.
+        components['external-cdr-uploader'].update({
+            'chunk-records': 2,
+            'request-timeout-ms': 500,
+            'request-retry-delay-ms': 10,
+            'request-max-retry-delay-ms': 50,
+        })
 
     return patch_config
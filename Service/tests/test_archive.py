@@ -0,0 +1,117 @@
+import gzip
+import json
+
+
+def _append_chunk(path, documents):
+    with open(path, 'ab') as archive:
+        offset = archive.tell()
+        member = gzip.compress(''.join(json.dumps(d) + '\n' for d in documents).encode())
+        archive.write(member)
+    return offset, len(member)
+
+
+async def test_archived_call_lookup(service_client, pgsql, archive_dir):
+    documents = [{'call_id': call_id, 'call': {'call_id': call_id}} for call_id in (7001, 7002)]
+    # A chunk written before this one must not get in the way.
+    _append_chunk(archive_dir / 'calls-20240101.jsonl.gz', [{'call_id': 7000}])
+    offset, length = _append_chunk(archive_dir / 'calls-20240101.jsonl.gz', documents)
+
+    cursor = pgsql['db'].cursor()
+    cursor.execute(
+        'INSERT INTO call_flow_processor.archived_calls '
+        '(call_id, archive_file, archive_offset, archive_length) '
+        "SELECT UNNEST(%s), 'calls-20240101.jsonl.gz', %s, %s",
+        ([7001, 7002], offset, length),
+    )
+
+    response = await service_client.get('/archive/calls', params={'call_id': 7002})
+    assert response.status == 200
+    assert response.json() == documents[1]
+
+
+async def test_archived_call_lookup_unknown_call(service_client):
+    response = await service_client.get('/archive/calls', params={'call_id': 123456})
+    assert response.status == 404
+
+
+async def test_archived_call_lookup_bad_id(service_client):
+    response = await service_client.get('/archive/calls', params={'call_id': 'abc'})
+    assert response.status == 400
+
+
+def _insert_call(cursor, call_id, uploaded_by):
+    cursor.execute(
+        'INSERT INTO call_flow_processor.calls '
+        '(call_id, status, started_at, finished_at, caller_number, callee_number, user_id) '
+        "VALUES (%s, 'COMPLETED', '2020-01-01 12:00:00', '2020-01-01 12:05:00', '+79991112233', '54321', 1)",
+        (call_id,),
+    )
+    cursor.execute(
+        'INSERT INTO call_flow_processor.connections '
+        '(connection_id, call_id, phone, initiated_at, answered_at, finished_at) '
+        "VALUES (%s, %s, '+79991112233', '2020-01-01 12:00:00', '2020-01-01 12:00:10', '2020-01-01 12:05:00')",
+        (call_id, call_id),
+    )
+    cursor.execute(
+        'INSERT INTO call_flow_processor.call_events (event_id, call_id, event_type, payload) '
+        "VALUES (%s, %s, 'hangup', '{}')",
+        (call_id, call_id),
+    )
+    for cdr_type in uploaded_by:
+        cursor.execute(
+            'INSERT INTO call_flow_processor.cdr_upload_info (cdr_type, call_id, upload_status, uploaded_at) '
+            "VALUES (%s, %s, 'uploaded', '2020-01-01 12:06:00')",
+            (cdr_type, call_id),
+        )
+
+
+def _count(cursor, table, call_id):
+    cursor.execute(f'SELECT count(*) FROM call_flow_processor.{table} WHERE call_id = %s', (call_id,))
+    return cursor.fetchone()[0]
+
+
+async def test_retention_archives_and_deletes_uploaded_calls(service_client, pgsql):
+    cursor = pgsql['db'].cursor()
+    _insert_call(cursor, 8001, ['internal_cdr', 'external_cdr'])
+    # Not taken by external_cdr yet: it has no row for that uploader at all.
+    _insert_call(cursor, 8002, ['internal_cdr'])
+
+    await service_client.run_task('distlock/call-retention')
+
+    for table in ('calls', 'connections', 'call_events', 'cdr_upload_info'):
+        assert _count(cursor, table, 8001) == 0, table
+    assert _count(cursor, 'calls', 8002) == 1
+    assert _count(cursor, 'archived_calls', 8002) == 0
+
+    response = await service_client.get('/archive/calls', params={'call_id': 8001})
+    assert response.status == 200
+    document = response.json()
+    assert document['call_id'] == 8001
+    assert document['call']['caller_number'] == '+79991112233'
+    assert [c['connection_id'] for c in document['connections']] == [8001]
+    assert [e['event_type'] for e in document['call_events']] == ['hangup']
+    assert sorted(u['cdr_type'] for u in document['cdr_upload_info']) == ['external_cdr', 'internal_cdr']
+
+
+async def test_retention_registers_archive_volume(service_client, pgsql, archive_dir):
+    await service_client.run_task('distlock/call-retention')
+
+    cursor = pgsql['db'].cursor()
+    cursor.execute('SELECT volume_id FROM call_flow_processor.archive_volume')
+    assert cursor.fetchall() == [((archive_dir / '.volume-id').read_text(),)]
+
+
+async def test_archived_call_lookup_on_another_volume(service_client, pgsql, archive_dir):
+    offset, length = _append_chunk(archive_dir / 'calls-20240101.jsonl.gz', [{'call_id': 7101}])
+    cursor = pgsql['db'].cursor()
+    # The archive was registered by an instance whose archive-dir is not ours.
+    cursor.execute("INSERT INTO call_flow_processor.archive_volume (volume_id) VALUES ('another-volume')")
+    cursor.execute(
+        'INSERT INTO call_flow_processor.archived_calls '
+        '(call_id, archive_file, archive_offset, archive_length) '
+        "VALUES (7101, 'calls-20240101.jsonl.gz', %s, %s)",
+        (offset, length),
+    )
+
+    response = await service_client.get('/archive/calls', params={'call_id': 7101})
+    assert response.status == 500
@@ -109,3 +109,62 @@ async def test_cdr_uploader_various_missing_sources(skip_mock, should_upload, mo
         assert len(cdrs) == 1
     else:
         assert len(cdrs) == 0
+
+
+def _reset_uploads(pgsql, cdr_type):
+    cursor = pgsql['db'].cursor()
+    cursor.execute('DELETE FROM call_flow_processor.cdrs')
+    cursor.execute(
+        'UPDATE call_flow_processor.cdr_upload_info '
+        "SET upload_status = 'pending', uploaded_at = NULL, lease_owner = NULL, lease_until = NULL, attempts = 0 "
+        'WHERE cdr_type = %s',
+        (cdr_type,),
+    )
+
+
+def _fetch_cdrs(pgsql):
+    cursor = pgsql['db'].cursor()
+    cursor.execute(
+        'SELECT call_id, call_start, call_end, caller_number, callee_number, duration_sec, call_result, call_events '
+        'FROM call_flow_processor.cdrs ORDER BY call_id'
+    )
+    return cursor.fetchall()
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_cdr_uploader_collect_modes_agree(service_client, pgsql, testpoint):
+    mode = {'value': 'sql'}
+
+    @testpoint('cdr-uploader-collect-mode')
+    def collect_mode(data):
+        return {'mode': mode['value']}
+
+    cdrs = {}
+    for value in ('sql', 'snapshot'):
+        mode['value'] = value
+        _reset_uploads(pgsql, 'internal_cdr')
+        await service_client.post('/admin/trigger-cdr-upload')
+        cdrs[value] = _fetch_cdrs(pgsql)
+
+    assert cdrs['sql']
+    assert cdrs['snapshot'] == cdrs['sql']
+    assert cdrs['snapshot'][0][5] == 300  # duration_sec, 12:00:00 - 12:05:00
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_cdr_uploader_rereads_snapshot_it_already_took(service_client, pgsql, testpoint):
+    @testpoint('cdr-uploader-collect-mode')
+    def collect_mode(data):
+        return {'mode': 'snapshot'}
+
+    _reset_uploads(pgsql, 'internal_cdr')
+    await service_client.post('/admin/trigger-cdr-upload')
+    assert _fetch_cdrs(pgsql)[0][5] == 300
+
+    # The external uploader hasn't taken the snapshot yet, so it is still
+    # cached; a second upload of the call must not be served from it.
+    cursor = pgsql['db'].cursor()
+    cursor.execute("UPDATE call_flow_processor.calls SET finished_at = finished_at + interval '1 minute'")
+    _reset_uploads(pgsql, 'internal_cdr')
+    await service_client.post('/admin/trigger-cdr-upload')
+    assert _fetch_cdrs(pgsql)[0][5] == 360
@@ -1,3 +1,4 @@
+import asyncio
 import pytest
 import json
 
@@ -119,3 +120,132 @@ async def test_external_cdr_uploader_various_sources(
         assert len(mock_external_records) == 1
     else:
         assert len(mock_external_records) == 0
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_call_events", "mock_connections", "mock_external_records")
+async def test_external_cdr_uploader_escapes_strings(service_client, mockserver, mock_external_records, pgsql):
+    name = 'Charlie "Chuck" O\\Neil\tRenée'
+    mockserver.json_handler("/operators")(lambda _req: mockserver.make_response(json.dumps([
+        {"operator_id": 300, "name": name, "extension": "100", "email": "charlie@test.com"},
+    ]), 200))
+    await service_client.post('/admin/trigger-external-cdr-upload')
+    assert len(mock_external_records) == 1
+    assert mock_external_records[0][0]['operator_name'] == name
+
+
+def _upload_status(pgsql, call_id):
+    cursor = pgsql['db'].cursor()
+    cursor.execute(
+        'SELECT upload_status, attempts FROM call_flow_processor.cdr_upload_info '
+        "WHERE cdr_type = 'external_cdr' AND call_id = %s",
+        (call_id,),
+    )
+    return cursor.fetchone()
+
+
+def _flaky_records(mockserver, failures):
+    """/records answering each request with the next of failures, then 200."""
+    received = []
+    outcomes = list(failures)
+
+    @mockserver.json_handler("/records")
+    async def handler(request):
+        outcome = outcomes.pop(0) if outcomes else None
+        if outcome == 'slow':
+            await asyncio.sleep(1)  # past request-timeout-ms
+        elif outcome is not None:
+            return mockserver.make_response('', outcome)
+        received.append(request.json)
+        return {}
+
+    return handler, received
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_external_cdr_delivery_retries_5xx(service_client, mockserver, pgsql):
+    handler, received = _flaky_records(mockserver, [503, 502])
+    await service_client.post('/admin/trigger-external-cdr-upload')
+    assert handler.times_called == 3
+    assert [len(body) for body in received] == [1]
+    assert _upload_status(pgsql, 200) == ('uploaded', 0)
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_external_cdr_delivery_retries_slow_response(service_client, mockserver, pgsql):
+    handler, received = _flaky_records(mockserver, ['slow'])
+    await service_client.post('/admin/trigger-external-cdr-upload')
+    assert handler.times_called == 2
+    assert _upload_status(pgsql, 200) == ('uploaded', 0)
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_external_cdr_delivery_gives_up_after_attempts(service_client, mockserver, pgsql):
+    handler, received = _flaky_records(mockserver, [500, 500, 500])
+    await service_client.post('/admin/trigger-external-cdr-upload')
+    assert handler.times_called == 3  # request-attempts
+    assert not received
+    # Left to the cdr_upload_info backoff.
+    assert _upload_status(pgsql, 200) == ('pending', 1)
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_external_cdr_delivery_fails_rejected_chunk_at_once(service_client, mockserver, pgsql):
+    handler, received = _flaky_records(mockserver, [400])
+    await service_client.post('/admin/trigger-external-cdr-upload')
+    assert handler.times_called == 1
+    assert not received
+    assert _upload_status(pgsql, 200) == ('failed', 1)
+
+
+@pytest.mark.usefixtures("mock_operators")
+async def test_external_cdr_delivery_splits_chunks(service_client, mockserver, mock_external_records, pgsql):
+    call_ids = [201, 202, 203]
+    mockserver.json_handler("/calls")(lambda _req: mockserver.make_response(json.dumps([
+        {"id": call_id, "status": "COMPLETED", "started_at": "2024-06-18T13:00:00Z",
+         "finished_at": "2024-06-18T13:05:40Z", "caller_number": "+19998887766",
+         "callee_number": "88888", "user_id": 300}
+        for call_id in call_ids
+    ]), 200))
+    mockserver.json_handler("/call_events")(lambda _req: mockserver.make_response(json.dumps([
+        {"event_id": call_id, "call_id": call_id, "event_type": "hangup", "payload": {}}
+        for call_id in call_ids
+    ]), 200))
+    mockserver.json_handler("/connections")(lambda _req: mockserver.make_response(json.dumps([
+        {"connection_id": call_id, "call_id": call_id, "phone": "+19998887766",
+         "initiated_at": "2024-06-18T13:00:00Z", "answered_at": "2024-06-18T13:00:10Z",
+         "finished_at": "2024-06-18T13:05:40Z"}
+        for call_id in call_ids
+    ]), 200))
+
+    await service_client.post('/admin/trigger-external-cdr-upload')
+    # chunk-records is 2 in tests, chunks are sent concurrently.
+    assert sorted(len(body) for body in mock_external_records) == [1, 2]
+    assert sorted(int(rec['call_id']) for body in mock_external_records for rec in body) == call_ids
+    for call_id in call_ids:
+        assert _upload_status(pgsql, call_id) == ('uploaded', 0)
+
+
+@pytest.mark.usefixtures("mock_calls", "mock_operators", "mock_call_events", "mock_connections")
+async def test_external_cdr_uploader_collect_modes_agree(service_client, mock_external_records, pgsql, testpoint):
+    mode = {'value': 'sql'}
+
+    @testpoint('cdr-uploader-collect-mode')
+    def collect_mode(data):
+        return {'mode': mode['value']}
+
+    records = {}
+    for value in ('sql', 'snapshot'):
+        mode['value'] = value
+        mock_external_records.clear()
+        pgsql['db'].cursor().execute(
+            'UPDATE call_flow_processor.cdr_upload_info '
+            "SET upload_status = 'pending', uploaded_at = NULL, lease_owner = NULL, lease_until = NULL, "
+            "attempts = 0 WHERE cdr_type = 'external_cdr'"
+        )
+        await service_client.post('/admin/trigger-external-cdr-upload')
+        records[value] = [rec for body in mock_external_records for rec in body]
+
+    assert records['sql']
+    assert records['snapshot'] == records['sql']
+    assert records['snapshot'][0]['wait_sec'] == 10
+    assert records['snapshot'][0]['talk_sec'] == 330
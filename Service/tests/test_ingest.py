@@ -0,0 +1,182 @@
+import pytest
+import json
+
+OPERATORS = [
+    {"operator_id": 400, "name": "Dana", "extension": "401", "email": "dana@test.com"},
+    {"operator_id": 401, "name": "Eve", "extension": "402", "email": "eve@test.com"},
+]
+
+
+async def test_ingest_operators_stores_batch(service_client, pgsql):
+    response = await service_client.post('/ingest/operators', data=json.dumps(OPERATORS))
+    assert response.status == 200
+    assert response.json() == {"accepted": 2, "rejected": 0}
+
+    operators = await pgsql['db'].fetch('SELECT * FROM operators ORDER BY operator_id;')
+    assert [op['name'] for op in operators] == ["Dana", "Eve"]
+
+
+async def test_ingest_accepts_results_object(service_client, pgsql):
+    body = {"results": OPERATORS[:1], "next_cursor": None}
+    response = await service_client.post('/ingest/operators', data=json.dumps(body))
+    assert response.status == 200
+    assert response.json() == {"accepted": 1, "rejected": 0}
+
+
+async def test_ingest_drops_invalid_rows(service_client, pgsql):
+    batch = OPERATORS + [{"operator_id": "not-a-number", "name": "Mallory"}]
+    response = await service_client.post('/ingest/operators', data=json.dumps(batch))
+    assert response.status == 200
+    assert response.json() == {"accepted": 2, "rejected": 1}
+
+
+async def test_ingest_rejects_malformed_json(service_client):
+    response = await service_client.post('/ingest/operators', data='[{"operator_id": 1,')
+    assert response.status == 400
+
+
+@pytest.mark.parametrize(
+    "path",
+    ['/ingest/calls', '/ingest/connections', '/ingest/call_events', '/ingest/operators'],
+)
+async def test_ingest_empty_batch(path, service_client):
+    response = await service_client.post(path, data='[]')
+    assert response.status == 200
+    assert response.json() == {"accepted": 0, "rejected": 0}
+
+
+def _varint(value):
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def _string(value):
+    return _varint(len(value.encode())) + value.encode()
+
+
+def _binary_operators(operators):
+    # Operator schema: operator_id, name, extension, email (binary_batch.hpp).
+    body = b'CFB' + bytes([2, 4, 0]) + _varint(len(operators))
+    for op in operators:
+        row = (_varint(op['operator_id'] << 1) + _string(op['name'])
+               + _string(op['extension']) + _string(op['email']))
+        body += _varint(len(row)) + row
+    return body
+
+
+async def test_ingest_binary_batch(service_client, pgsql):
+    response = await service_client.post(
+        '/ingest/operators',
+        data=_binary_operators(OPERATORS),
+        headers={'Content-Type': 'application/x-cfp-batch'},
+    )
+    assert response.status == 200
+    assert response.json() == {"accepted": 2, "rejected": 0}
+
+    operators = await pgsql['db'].fetch('SELECT * FROM operators ORDER BY operator_id;')
+    assert [op['email'] for op in operators] == ["dana@test.com", "eve@test.com"]
+
+
+async def test_ingest_rejects_truncated_binary_batch(service_client):
+    response = await service_client.post(
+        '/ingest/operators',
+        data=_binary_operators(OPERATORS)[:-3],
+        headers={'Content-Type': 'application/x-cfp-batch'},
+    )
+    assert response.status == 400
+
+
+async def _ingest_call(service_client, call_id):
+    """Creates the call that ingested events and connections refer to."""
+    call = {"id": call_id, "status": "completed", "started_at": "2024-01-01T10:00:00Z",
+            "finished_at": "2024-01-01T10:05:00Z", "caller_number": "+100", "callee_number": "+200", "user_id": 7}
+    response = await service_client.post('/ingest/calls', data=json.dumps([call]))
+    assert response.status == 200
+
+
+async def test_ingest_call_events_stores_payload_as_jsonb(service_client, pgsql):
+    await _ingest_call(service_client, 90)
+    events = [{"event_id": 900, "call_id": 90, "event_type": "answered", "payload": {"operator_id": 7}}]
+    response = await service_client.post('/ingest/call_events', data=json.dumps(events))
+    assert response.status == 200
+
+    rows = await pgsql['db'].fetch(
+        'SELECT pg_typeof(payload)::text AS type, payload->>\'operator_id\' AS operator_id '
+        'FROM call_events WHERE event_id = 900;'
+    )
+    assert [(row['type'], row['operator_id']) for row in rows] == [('jsonb', '7')]
+
+
+async def test_ingest_calls_stores_all_fields(service_client, pgsql):
+    calls = [
+        {"id": 910, "status": "completed", "started_at": "2024-01-01T10:00:00Z",
+         "finished_at": "2024-01-01T10:05:00Z", "caller_number": "+100", "callee_number": "+200", "user_id": 7},
+        {"id": 911, "status": "ringing", "started_at": "2024-01-01T10:01:00Z",
+         "finished_at": None, "caller_number": "+101", "callee_number": "+201", "user_id": 7},
+        {"id": 912, "status": "ringing", "started_at": "2024-01-01T10:02:00Z", "user_id": 7},
+    ]
+    response = await service_client.post('/ingest/calls', data=json.dumps(calls))
+    assert response.status == 200
+    assert response.json() == {"accepted": 2, "rejected": 1}
+
+    rows = await pgsql['db'].fetch(
+        'SELECT call_id, finished_at IS NULL AS unfinished, caller_number, callee_number '
+        'FROM calls WHERE call_id IN (910, 911, 912) ORDER BY call_id;'
+    )
+    assert [tuple(row.values()) for row in rows] == [
+        (910, False, '+100', '+200'),
+        (911, True, '+101', '+201'),
+    ]
+
+
+async def test_ingest_rejects_row_with_malformed_payload(service_client, pgsql):
+    await _ingest_call(service_client, 90)
+    # The payload's brackets balance, but its content is not valid JSON.
+    body = (
+        '[{"event_id": 901, "call_id": 90, "event_type": "answered", "payload": {"legs": [1, }]},'
+        ' {"event_id": 902, "call_id": 90, "event_type": "answered", "payload": {"legs": [1]}}]'
+    )
+    response = await service_client.post('/ingest/call_events', data=body)
+    assert response.status == 200
+    assert response.json() == {"accepted": 1, "rejected": 1}
+
+    rows = await pgsql['db'].fetch('SELECT event_id FROM call_events WHERE event_id IN (901, 902);')
+    assert [row['event_id'] for row in rows] == [902]
+
+
+async def test_ingest_keeps_event_types_past_symbol_table_cap(service_client, pgsql):
+    # The symbol table interns at most 4096 values; later ones must still be stored.
+    await _ingest_call(service_client, 90)
+    events = [
+        {"event_id": 10000 + i, "call_id": 90, "event_type": f"custom-{i}", "payload": {}} for i in range(4200)
+    ]
+    response = await service_client.post('/ingest/call_events', data=json.dumps(events))
+    assert response.status == 200
+    assert response.json() == {"accepted": 4200, "rejected": 0}
+
+    rows = await pgsql['db'].fetch(
+        'SELECT event_type FROM call_events WHERE event_id IN (10000, 14199) ORDER BY event_id;'
+    )
+    assert [row['event_type'] for row in rows] == ['custom-0', 'custom-4199']
+
+
+async def test_ingest_rejects_batch_over_max_rows(service_client):
+    # max-batch-rows is 5000.
+    operators = [
+        {"operator_id": i, "name": "Op", "extension": str(i), "email": "op@test.com"} for i in range(5001)
+    ]
+    response = await service_client.post('/ingest/operators', data=json.dumps(operators))
+    assert response.status == 413
+
+
+async def test_ingest_checks_binary_row_count_before_rows(service_client):
+    # The header announces more rows than accepted; none follow.
+    body = b'CFB' + bytes([2, 4, 0]) + _varint(5001)
+    response = await service_client.post(
+        '/ingest/operators', data=body, headers={'Content-Type': 'application/x-cfp-batch'},
+    )
+    assert response.status == 413
@@ -0,0 +1,30 @@
+import json
+
+OPERATORS = [
+    {"operator_id": 500, "name": "Frank", "extension": "501", "email": "frank@test.com"},
+    {"operator_id": 501, "name": "Grace", "extension": "502", "email": "grace@test.com"},
+]
+
+
+async def test_statistics_operators_served_from_cache(service_client):
+    response = await service_client.post('/ingest/operators', data=json.dumps(OPERATORS))
+    assert response.status == 200
+
+    await service_client.invalidate_caches(cache_names=['operator-cache'])
+
+    response = await service_client.get('/statistics/operators')
+    assert response.status == 200
+    names = sorted(stat['operator_name'] for stat in response.json())
+    assert names == ["Frank", "Grace"]
+
+
+async def test_operator_update_reaches_cache(service_client):
+    await service_client.post('/ingest/operators', data=json.dumps(OPERATORS[:1]))
+    await service_client.invalidate_caches(cache_names=['operator-cache'])
+
+    renamed = [dict(OPERATORS[0], name="Francis")]
+    await service_client.post('/ingest/operators', data=json.dumps(renamed))
+    await service_client.invalidate_caches(cache_names=['operator-cache'], clean_update=False)
+
+    response = await service_client.get('/statistics/operators')
+    assert [stat['operator_name'] for stat in response.json()] == ["Francis"]
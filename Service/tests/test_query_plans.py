@@ -0,0 +1,98 @@
+import json
+import pathlib
+import re
+
+import pytest
+
+SOURCES = pathlib.Path(__file__).parent.parent / 'src'
+
+# Access paths of the controllers and CDRUploadInfo: the constant holding the
+# statement, the arguments to plan it with and the index it must use. With
+# sequential scans disabled the planner still picks one when no index fits,
+# so a Seq Scan in the plan means the query lost its index.
+QUERIES = {
+    'calls_by_id': (
+        'components/controllers/call_controller.cpp', 'kSelectCalls',
+        ([1, 2, 3],),
+        'calls_p0_pkey',
+    ),
+    'events_by_call': (
+        'components/controllers/call_event_controller.cpp', 'kSelectEventsWithPayload',
+        ([1, 2, 3],),
+        'call_id_idx',
+    ),
+    'connections_by_call': (
+        'components/controllers/connection_controller.cpp', 'kSelectConnections',
+        ([1, 2, 3],),
+        'call_id_idx',
+    ),
+    'claim_pending': (
+        'components/cdr_uploaders/cdr_upload_info.cpp', 'kClaimPending',
+        ('external_cdr', 'test-owner', 100, 1000),
+        'cdr_upload_info_pending_idx',
+    ),
+    'finished_since_watermark': (
+        'components/cdr_uploaders/cdr_upload_info.cpp', 'kEnqueueFinishedCalls',
+        ('external_cdr',),
+        'finished_calls_finished_txid_idx',
+    ),
+}
+
+_LITERAL = r'"((?:[^"\\]|\\.)*)"'
+
+
+def _statement(source, constant):
+    """The SQL the service runs: the string literals of a
+    `constexpr const char* <constant>` in the service sources."""
+    text = (SOURCES / source).read_text()
+    match = re.search(
+        r'constexpr const char\* ' + constant + r'\s*=((?:\s*' + _LITERAL + r')+);', text,
+    )
+    assert match, f'{constant} not found in {source}'
+    return ''.join(re.findall(_LITERAL, match.group(1))).rstrip(';')
+
+
+def _nodes(plan):
+    yield plan
+    for child in plan.get('Plans', []):
+        yield from _nodes(child)
+
+
+def _plan(pgsql, name):
+    source, constant, args, _ = QUERIES[name]
+    cursor = pgsql['db'].cursor()
+    cursor.execute('SET search_path TO call_flow_processor')
+    cursor.execute('SET enable_seqscan = off')
+    cursor.execute('DEALLOCATE ALL')
+    # Prepared like the driver does, so $n parameters get the same types.
+    cursor.execute('PREPARE checked AS ' + _statement(source, constant))
+    placeholders = ', '.join(['%s'] * len(args))
+    cursor.execute(f'EXPLAIN (FORMAT JSON) EXECUTE checked({placeholders})', args)
+    plan = cursor.fetchone()[0]
+    if isinstance(plan, str):
+        plan = json.loads(plan)
+    return plan[0]['Plan']
+
+
+@pytest.mark.parametrize('name', sorted(QUERIES))
+def test_query_uses_index(name, pgsql):
+    index = QUERIES[name][3]
+    nodes = list(_nodes(_plan(pgsql, name)))
+    assert not [n for n in nodes if n['Node Type'] == 'Seq Scan'], nodes
+    assert any(index in n.get('Index Name', '') for n in nodes), nodes
+
+
+def test_lookups_by_id_prune_partitions(pgsql):
+    relations = {n['Relation Name'] for n in _nodes(_plan(pgsql, 'calls_by_id')) if 'Relation Name' in n}
+    assert relations == {'calls_p0'}
+
+
+def test_partitions_are_kept_ahead(pgsql):
+    cursor = pgsql['db'].cursor()
+    cursor.execute("SELECT call_flow_processor.ensure_id_partitions('call_events')")
+    cursor.execute(
+        'SELECT count(*) FROM pg_inherits '
+        "WHERE inhparent = 'call_flow_processor.call_events'::regclass",
+    )
+    # p0..p4 and the default partition.
+    assert cursor.fetchone()[0] == 6